@@ -0,0 +1,425 @@
+#define _GNU_SOURCE
+
+#include "map.h"
+#include "pathfind.h"
+#include "hpa.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <time.h>
+
+/*
+ * Benchmarks map_pathfind() on generated maps
+ *
+ * Open, maze, rooms and unreachable maps are generated at every size up to the largest one asked for, and the same
+ * random start and goal pairs are searched in every pathfinding mode. Queries per second, nodes expanded, heap
+ * allocations per query and the peak heap use while searching are printed and written to a CSV file
+ *
+ * Allocations are counted by wrapping malloc, calloc, realloc and free at link time, see the grid_bench make target
+ *
+ * Usage: ./grid_bench [output.csv] [largest size] [queries per map]
+ */
+
+const int GRID_BENCH_SIZES[4] = { 64, 256, 1024, 4096 };
+const int GRID_BENCH_SIZE_COUNT = 4;
+const int GRID_BENCH_ROOM_SIZE = 16; // rooms maps are split into cells this big with one room in each
+const unsigned int GRID_BENCH_SEED = 12345;
+
+typedef enum grid_type{
+    GRID_OPEN,
+    GRID_MAZE,
+    GRID_ROOMS,
+    GRID_UNREACHABLE,
+    NUM_GRID_TYPES
+} grid_type;
+
+static const char* grid_names[NUM_GRID_TYPES] = { "open", "maze", "rooms", "unreachable" };
+static const char* mode_names[3] = { "astar", "jps", "hpa" };
+
+// Heap tracking
+
+static long heap_allocations = 0;
+static long heap_bytes = 0;
+static long heap_peak_bytes = 0;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+static void heap_track(void* pointer, long sign){
+
+    if(pointer == NULL){
+
+        return;
+    }
+
+    heap_bytes += sign * (long)malloc_usable_size(pointer);
+    if(heap_bytes > heap_peak_bytes){
+
+        heap_peak_bytes = heap_bytes;
+    }
+}
+
+void* __wrap_malloc(size_t size){
+
+    void* pointer = __real_malloc(size);
+    heap_allocations++;
+    heap_track(pointer, 1);
+    return pointer;
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+
+    void* pointer = __real_calloc(count, size);
+    heap_allocations++;
+    heap_track(pointer, 1);
+    return pointer;
+}
+
+void* __wrap_realloc(void* pointer, size_t size){
+
+    heap_track(pointer, -1);
+    void* new_pointer = __real_realloc(pointer, size);
+    heap_allocations++;
+    heap_track(new_pointer != NULL ? new_pointer : pointer, 1);
+    return new_pointer;
+}
+
+void __wrap_free(void* pointer){
+
+    heap_track(pointer, -1);
+    __real_free(pointer);
+}
+
+// Map generation
+
+// Own random numbers so the maps and queries come out the same on every platform
+static unsigned int random_state;
+
+static int random_int(int max){
+
+    random_state = (random_state * 1103515245) + 12345;
+    return (random_state >> 8) % max;
+}
+
+static void set_wall(map* the_map, int x, int y, int wall){
+
+    the_map->wall[x + (y * the_map->width)] = wall;
+}
+
+// Carves a maze with passages on the odd squares, then knocks out a few extra walls so there's more than one way around
+static void generate_maze(map* the_map){
+
+    int cells_wide = (the_map->width - 1) / 2;
+    int cells_high = (the_map->height - 1) / 2;
+    int* stack = malloc(sizeof(int) * cells_wide * cells_high);
+    bool* visited = calloc(cells_wide * cells_high, sizeof(bool));
+
+    static const int direction_x[4] = { 0, 1, 0, -1 };
+    static const int direction_y[4] = { -1, 0, 1, 0 };
+
+    stack[0] = 0;
+    int stack_size = 1;
+    visited[0] = true;
+    set_wall(the_map, 1, 1, 0);
+    while(stack_size != 0){
+
+        int cell = stack[stack_size - 1];
+        int cell_x = cell % cells_wide;
+        int cell_y = cell / cells_wide;
+
+        int options[4];
+        int option_count = 0;
+        for(int direction = 0; direction < 4; direction++){
+
+            int next_x = cell_x + direction_x[direction];
+            int next_y = cell_y + direction_y[direction];
+            if(next_x >= 0 && next_x < cells_wide && next_y >= 0 && next_y < cells_high && !visited[next_x + (next_y * cells_wide)]){
+
+                options[option_count] = direction;
+                option_count++;
+            }
+        }
+
+        if(option_count == 0){
+
+            stack_size--;
+            continue;
+        }
+
+        int direction = options[random_int(option_count)];
+        int next_x = cell_x + direction_x[direction];
+        int next_y = cell_y + direction_y[direction];
+        visited[next_x + (next_y * cells_wide)] = true;
+        set_wall(the_map, (cell_x * 2) + 1 + direction_x[direction], (cell_y * 2) + 1 + direction_y[direction], 0);
+        set_wall(the_map, (next_x * 2) + 1, (next_y * 2) + 1, 0);
+        stack[stack_size] = next_x + (next_y * cells_wide);
+        stack_size++;
+    }
+
+    for(int i = 0; i < cells_wide * cells_high / 16; i++){
+
+        int x = 1 + random_int(the_map->width - 2);
+        int y = 1 + random_int(the_map->height - 2);
+        if((x + y) % 2 == 1){
+
+            set_wall(the_map, x, y, 0);
+        }
+    }
+
+    free(stack);
+    free(visited);
+}
+
+// Puts a room of random size in every cell and joins each one to the rooms to its right and below with a corridor
+static void generate_rooms(map* the_map){
+
+    int cells_wide = the_map->width / GRID_BENCH_ROOM_SIZE;
+    int cells_high = the_map->height / GRID_BENCH_ROOM_SIZE;
+    int* center_x = malloc(sizeof(int) * cells_wide * cells_high);
+    int* center_y = malloc(sizeof(int) * cells_wide * cells_high);
+
+    for(int cell = 0; cell < cells_wide * cells_high; cell++){
+
+        int room_width = 4 + random_int(GRID_BENCH_ROOM_SIZE - 6);
+        int room_height = 4 + random_int(GRID_BENCH_ROOM_SIZE - 6);
+        int room_x = ((cell % cells_wide) * GRID_BENCH_ROOM_SIZE) + 1 + random_int(GRID_BENCH_ROOM_SIZE - room_width - 1);
+        int room_y = ((cell / cells_wide) * GRID_BENCH_ROOM_SIZE) + 1 + random_int(GRID_BENCH_ROOM_SIZE - room_height - 1);
+        for(int y = room_y; y < room_y + room_height; y++){
+
+            for(int x = room_x; x < room_x + room_width; x++){
+
+                set_wall(the_map, x, y, 0);
+            }
+        }
+        center_x[cell] = room_x + (room_width / 2);
+        center_y[cell] = room_y + (room_height / 2);
+    }
+
+    for(int cell = 0; cell < cells_wide * cells_high; cell++){
+
+        int neighbors[2] = { (cell % cells_wide) + 1 < cells_wide ? cell + 1 : -1, (cell / cells_wide) + 1 < cells_high ? cell + cells_wide : -1 };
+        for(int i = 0; i < 2; i++){
+
+            if(neighbors[i] == -1){
+
+                continue;
+            }
+
+            int x = center_x[cell];
+            int y = center_y[cell];
+            while(x != center_x[neighbors[i]]){
+
+                set_wall(the_map, x, y, 0);
+                x += x < center_x[neighbors[i]] ? 1 : -1;
+            }
+            while(y != center_y[neighbors[i]]){
+
+                set_wall(the_map, x, y, 0);
+                y += y < center_y[neighbors[i]] ? 1 : -1;
+            }
+        }
+    }
+
+    free(center_x);
+    free(center_y);
+}
+
+// Only the layers that pathfinding reads are filled in
+map* generate_map(grid_type type, int size){
+
+    map* new_map = malloc(sizeof(map));
+    new_map->width = size;
+    new_map->height = size;
+    new_map->wall = malloc(sizeof(int) * size * size);
+    new_map->ceil = NULL;
+    new_map->floor = NULL;
+    new_map->objects = calloc(size * size, sizeof(int));
+    new_map->entities = NULL;
+    new_map->collidemap = malloc(sizeof(bool) * size * size);
+    new_map->collide_revision = 0;
+    new_map->components = NULL;
+    new_map->fill_queue = NULL;
+    new_map->jump_distances = NULL;
+    new_map->search = NULL;
+    new_map->hierarchy = NULL;
+
+    // Open and unreachable maps start empty, the others get carved out of solid wall
+    int fill = type == GRID_MAZE || type == GRID_ROOMS ? 1 : 0;
+    for(int i = 0; i < size * size; i++){
+
+        new_map->wall[i] = fill;
+    }
+
+    if(type == GRID_MAZE){
+
+        generate_maze(new_map);
+
+    }else if(type == GRID_ROOMS){
+
+        generate_rooms(new_map);
+
+    }else if(type == GRID_UNREACHABLE){
+
+        // A wall straight down the middle, every query goes from one side to the other
+        for(int y = 0; y < size; y++){
+
+            set_wall(new_map, size / 2, y, 1);
+        }
+    }
+
+    for(int i = 0; i < size; i++){
+
+        set_wall(new_map, i, 0, 1);
+        set_wall(new_map, i, size - 1, 1);
+        set_wall(new_map, 0, i, 1);
+        set_wall(new_map, size - 1, i, 1);
+    }
+
+    map_generate_collidemap(new_map);
+    new_map->hierarchy = hpa_create(new_map);
+
+    return new_map;
+}
+
+// Picks an open square, from the given range of columns
+static vector random_open_square(map* the_map, int min_x, int max_x){
+
+    while(true){
+
+        int x = min_x + random_int(max_x - min_x);
+        int y = random_int(the_map->height);
+        if(!the_map->collidemap[x + (y * the_map->width)]){
+
+            return (vector){ .x = x, .y = y };
+        }
+    }
+}
+
+// Benchmark
+
+typedef struct bench_result{
+    long queries;
+    long found;
+    long nodes_expanded;
+    long allocations;
+    long peak_bytes;
+    double seconds;
+} bench_result;
+
+double now_seconds(){
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + (time.tv_nsec / 1000000000.0);
+}
+
+bench_result bench_mode(map* the_map, pathfind_mode mode, vector* starts, vector* goals, int query_count){
+
+    bench_result result = (bench_result){ .queries = 0, .found = 0, .nodes_expanded = 0, .allocations = 0, .peak_bytes = 0, .seconds = 0 };
+    pathfind_active_mode = mode;
+
+    // Every mode pays for its own search memory
+    if(the_map->search != NULL){
+
+        pathfind_search_free(the_map->search);
+        the_map->search = NULL;
+    }
+
+    path solution = (path){ .squares = NULL, .length = 0, .capacity = 0 };
+    long allocations_before = heap_allocations;
+    long bytes_before = heap_bytes;
+    heap_peak_bytes = heap_bytes;
+
+    for(int i = 0; i < query_count; i++){
+
+        double before = now_seconds();
+        bool found = map_pathfind(the_map, starts[i], goals[i], &solution);
+        result.seconds += now_seconds() - before;
+
+        result.queries++;
+        if(found){
+
+            result.found++;
+        }
+        if(mode == PATHFIND_MODE_HPA){
+
+            result.nodes_expanded += the_map->hierarchy->nodes_expanded;
+
+        }else if(the_map->search != NULL){
+
+            result.nodes_expanded += the_map->search->nodes_expanded;
+        }
+    }
+
+    result.allocations = heap_allocations - allocations_before;
+    result.peak_bytes = heap_peak_bytes - bytes_before;
+    path_free(&solution);
+
+    return result;
+}
+
+int main(int argc, char** argv){
+
+    const char* output_path = argc > 1 ? argv[1] : "grid_bench.csv";
+    int largest_size = argc > 2 ? atoi(argv[2]) : GRID_BENCH_SIZES[GRID_BENCH_SIZE_COUNT - 1];
+    int queries_per_map = argc > 3 ? atoi(argv[3]) : 100;
+
+    FILE* output = fopen(output_path, "w");
+    if(output == NULL){
+
+        printf("Error opening %s!\n", output_path);
+        return 1;
+    }
+    fprintf(output, "map,size,mode,queries,found,queries_per_second,nodes_per_query,allocations_per_query,peak_bytes\n");
+
+    vector* starts = malloc(sizeof(vector) * queries_per_map);
+    vector* goals = malloc(sizeof(vector) * queries_per_map);
+
+    for(int s = 0; s < GRID_BENCH_SIZE_COUNT && GRID_BENCH_SIZES[s] <= largest_size; s++){
+
+        int size = GRID_BENCH_SIZES[s];
+        for(int type = 0; type < NUM_GRID_TYPES; type++){
+
+            random_state = GRID_BENCH_SEED + size + type;
+            map* the_map = generate_map(type, size);
+
+            for(int i = 0; i < queries_per_map; i++){
+
+                if(type == GRID_UNREACHABLE){
+
+                    starts[i] = random_open_square(the_map, 0, size / 2);
+                    goals[i] = random_open_square(the_map, (size / 2) + 1, size);
+
+                }else{
+
+                    starts[i] = random_open_square(the_map, 0, size);
+                    goals[i] = random_open_square(the_map, 0, size);
+                }
+            }
+
+            printf("%s %ix%i\n", grid_names[type], size, size);
+            for(int mode = 0; mode < 3; mode++){
+
+                bench_result result = bench_mode(the_map, mode, starts, goals, queries_per_map);
+                double queries_per_second = result.queries / result.seconds;
+                double nodes_per_query = result.nodes_expanded / (double)result.queries;
+                double allocations_per_query = result.allocations / (double)result.queries;
+
+                printf("    %-6s %10.1f queries/s %12.1f nodes/query %8.2f allocs/query %12li peak bytes %4li/%li found\n", mode_names[mode], queries_per_second, nodes_per_query, allocations_per_query, result.peak_bytes, result.found, result.queries);
+                fprintf(output, "%s,%i,%s,%li,%li,%.1f,%.1f,%.3f,%li\n", grid_names[type], size, mode_names[mode], result.queries, result.found, queries_per_second, nodes_per_query, allocations_per_query, result.peak_bytes);
+            }
+
+            map_free(the_map);
+        }
+    }
+
+    free(starts);
+    free(goals);
+    fclose(output);
+
+    return 0;
+}
@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "map.h"
+#include "particles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Times particle_list_update() with the particle list kept close to full
+ *
+ * Every tick the open squares of the map take turns throwing off a burst of sparks, enough to replace the ones that
+ * finished the tick before, so the list stays at the live count asked for while particles keep hitting walls, the
+ * floor and running out of life. The average update time per tick and per particle is printed, along with how much of
+ * a 60 updates per second frame that is
+ *
+ * Usage: ./particle_bench [live particles] [ticks] [map.tmx]
+ */
+
+const int PARTICLE_BENCH_BURST = 64;
+const float PARTICLE_BENCH_LIFE = 60.0;
+const double PARTICLE_BENCH_FRAME = 1.0 / 60.0;
+
+double now_seconds(){
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + (time.tv_nsec / 1000000000.0);
+}
+
+int main(int argc, char** argv){
+
+    int live = argc > 1 ? atoi(argv[1]) : 12000;
+    int ticks = argc > 2 ? atoi(argv[2]) : 5000;
+    const char* map_path = argc > 3 ? argv[3] : "./tiled/test.tmx";
+
+    map* the_map = map_load_from_tmx(map_path);
+    if(the_map == NULL){
+
+        printf("Error! Couldn't load %s\n", map_path);
+        return 1;
+    }
+
+    int open_count = 0;
+    int* open_squares = malloc(sizeof(int) * the_map->width * the_map->height);
+    for(int i = 0; i < the_map->width * the_map->height; i++){
+
+        if(!the_map->wall[i]){
+
+            open_squares[open_count] = i;
+            open_count++;
+        }
+    }
+    if(open_count == 0){
+
+        printf("Error! %s has no open squares\n", map_path);
+        return 1;
+    }
+
+    particle_list particles;
+    particle_list_init(&particles, live + PARTICLE_BENCH_BURST);
+
+    double seconds = 0;
+    long particle_ticks = 0;
+    int next_square = 0;
+    for(int tick = 0; tick < ticks; tick++){
+
+        while(particles.store.count < live){
+
+            int square = open_squares[next_square];
+            next_square = (next_square + 1) % open_count;
+            vector position = (vector){ .x = (square % the_map->width) + 0.5, .y = (square / the_map->width) + 0.5 };
+            particle_burst(&particles, PARTICLE_BOLT_SPARK, position, 0, ZERO_VECTOR, 0.04, PARTICLE_BENCH_BURST, PARTICLE_BENCH_LIFE);
+        }
+
+        particle_ticks += particles.store.count;
+        double before = now_seconds();
+        particle_list_update(&particles, the_map);
+        seconds += now_seconds() - before;
+    }
+
+    double tick_seconds = seconds / ticks;
+    printf("%i ticks, %.0f live particles on average\n", ticks, (double)particle_ticks / ticks);
+    printf("update: %.1f us per tick, %.2f ns per particle, %.2f%% of a frame\n", tick_seconds * 1000000.0, (seconds / particle_ticks) * 1000000000.0, (tick_seconds / PARTICLE_BENCH_FRAME) * 100);
+
+    particle_list_free(&particles);
+    free(open_squares);
+    map_free(the_map);
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "map.h"
+#include "pathfind.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Compares A* and JPS on the game's maps
+ *
+ * Every pair of open squares on each map is searched once in each mode. The path lengths of the two modes are checked
+ * against each other and the average nodes expanded and time per query are printed
+ *
+ * Usage: ./pathfind_bench [map.tmx ...]
+ */
+
+typedef struct bench_result{
+    long queries;
+    long found;
+    long nodes_expanded;
+    double seconds;
+} bench_result;
+
+static const char* mode_names[2] = { "A*", "JPS" };
+
+double now_seconds(){
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + (time.tv_nsec / 1000000000.0);
+}
+
+// Runs one query and returns the length of the path found, or -1 if there wasn't one
+int bench_query(pathfind_search* search, path* solution, pathfind_mode mode, vector start, vector goal, bench_result* result){
+
+    pathfind_active_mode = mode;
+
+    double before = now_seconds();
+    pathfind_search_begin(search, start, goal);
+    pathfind_status status = pathfind_search_run(search, 0);
+    result->seconds += now_seconds() - before;
+
+    result->queries++;
+    result->nodes_expanded += search->nodes_expanded;
+    if(status != PATHFIND_FOUND){
+
+        return -1;
+    }
+
+    result->found++;
+    pathfind_search_get_path(search, solution);
+    return solution->length;
+}
+
+int main(int argc, char** argv){
+
+    const char* default_maps[1] = { "./tiled/test.tmx" };
+    const char** map_paths = argc > 1 ? (const char**)(argv + 1) : default_maps;
+    int map_count = argc > 1 ? argc - 1 : 1;
+
+    int mismatches = 0;
+    for(int m = 0; m < map_count; m++){
+
+        map* the_map = map_load_from_tmx(map_paths[m]);
+        if(the_map == NULL){
+
+            continue;
+        }
+
+        int map_size = the_map->width * the_map->height;
+        pathfind_search* search = pathfind_search_create(the_map);
+        path solution = (path){ .squares = NULL, .length = 0, .capacity = 0 };
+        bench_result results[2];
+        for(int mode = 0; mode < 2; mode++){
+
+            results[mode] = (bench_result){ .queries = 0, .found = 0, .nodes_expanded = 0, .seconds = 0 };
+        }
+
+        for(int start = 0; start < map_size; start++){
+
+            for(int goal = 0; goal < map_size; goal++){
+
+                if(the_map->collidemap[start] || the_map->collidemap[goal]){
+
+                    continue;
+                }
+
+                vector start_square = (vector){ .x = start % the_map->width, .y = start / the_map->width };
+                vector goal_square = (vector){ .x = goal % the_map->width, .y = goal / the_map->width };
+                int astar_length = bench_query(search, &solution, PATHFIND_MODE_ASTAR, start_square, goal_square, &results[PATHFIND_MODE_ASTAR]);
+                int jps_length = bench_query(search, &solution, PATHFIND_MODE_JPS, start_square, goal_square, &results[PATHFIND_MODE_JPS]);
+                if(astar_length != jps_length){
+
+                    mismatches++;
+                }
+            }
+        }
+
+        printf("%s (%ix%i)\n", map_paths[m], the_map->width, the_map->height);
+        for(int mode = 0; mode < 2; mode++){
+
+            bench_result* result = &results[mode];
+            printf("    %-4s %8li queries %8li found %10.2f nodes/query %10.3f us/query\n", mode_names[mode], result->queries, result->found, result->nodes_expanded / (double)result->queries, (result->seconds * 1000000.0) / result->queries);
+        }
+
+        path_free(&solution);
+        pathfind_search_free(search);
+        map_free(the_map);
+    }
+
+    if(mismatches != 0){
+
+        printf("%i path lengths differed between A* and JPS!\n", mismatches);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#include "depth_bounds.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+void depth_bounds_init(depth_bounds* bounds, int width){
+
+    int total = 0;
+    int size = width;
+    bounds->level_count = 0;
+    while(1){
+
+        bounds->level_offsets[bounds->level_count] = total;
+        bounds->level_sizes[bounds->level_count] = size;
+        bounds->level_count++;
+        total += size;
+        if(size <= 1){
+
+            break;
+        }
+        size = (size + 1) / 2;
+    }
+
+    bounds->nearest = malloc(sizeof(float) * total);
+    bounds->farthest = malloc(sizeof(float) * total);
+}
+
+void depth_bounds_free(depth_bounds* bounds){
+
+    free(bounds->nearest);
+    free(bounds->farthest);
+}
+
+void depth_bounds_build(depth_bounds* bounds, const float* depths){
+
+    for(int i = 0; i < bounds->level_sizes[0]; i++){
+
+        bounds->nearest[i] = depths[i];
+        bounds->farthest[i] = depths[i];
+    }
+
+    for(int level = 1; level < bounds->level_count; level++){
+
+        const float* child_nearest = bounds->nearest + bounds->level_offsets[level - 1];
+        const float* child_farthest = bounds->farthest + bounds->level_offsets[level - 1];
+        float* nearest = bounds->nearest + bounds->level_offsets[level];
+        float* farthest = bounds->farthest + bounds->level_offsets[level];
+        int child_size = bounds->level_sizes[level - 1];
+        for(int i = 0; i < bounds->level_sizes[level]; i++){
+
+            // The last entry of a level with an odd size only has one child
+            int left = i * 2;
+            int right = left + 1 < child_size ? left + 1 : left;
+            nearest[i] = child_nearest[left] < child_nearest[right] ? child_nearest[left] : child_nearest[right];
+            farthest[i] = child_farthest[left] > child_farthest[right] ? child_farthest[left] : child_farthest[right];
+        }
+    }
+}
+
+void depth_bounds_query(const depth_bounds* bounds, int first, int last, float* nearest, float* farthest){
+
+    *nearest = INFINITY;
+    *farthest = -INFINITY;
+
+    // Walk up the levels, taking the entries at either end of the run that don't share a parent with the rest of it
+    int level = 0;
+    while(first < last){
+
+        const float* level_nearest = bounds->nearest + bounds->level_offsets[level];
+        const float* level_farthest = bounds->farthest + bounds->level_offsets[level];
+        if(first & 1){
+
+            *nearest = level_nearest[first] < *nearest ? level_nearest[first] : *nearest;
+            *farthest = level_farthest[first] > *farthest ? level_farthest[first] : *farthest;
+            first++;
+        }
+        if(last & 1){
+
+            last--;
+            *nearest = level_nearest[last] < *nearest ? level_nearest[last] : *nearest;
+            *farthest = level_farthest[last] > *farthest ? level_farthest[last] : *farthest;
+        }
+
+        first /= 2;
+        last /= 2;
+        level++;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * The nearest and farthest depth over any run of screen columns, for deciding whether a sprite is behind the walls
+ * without checking every column it covers
+ *
+ * Built from the wall depths once a frame as a pyramid: the first level is the columns themselves, and each level
+ * after that has the nearest and farthest of each pair in the level below, so any run of columns is covered by at
+ * most two entries per level. A sprite at least as far as the farthest wall in its run is hidden completely, and one
+ * nearer than the nearest is in front of every column
+ */
+
+typedef struct depth_bounds{
+    float* nearest; // every level one after the other, starting with the columns
+    float* farthest;
+    int level_offsets[32];
+    int level_sizes[32];
+    int level_count;
+} depth_bounds;
+
+void depth_bounds_init(depth_bounds* bounds, int width);
+void depth_bounds_free(depth_bounds* bounds);
+void depth_bounds_build(depth_bounds* bounds, const float* depths); // depths has a value for each of the width columns
+void depth_bounds_query(const depth_bounds* bounds, int first, int last, float* nearest, float* farthest); // over columns first to last - 1, in O(log width)
@@ -26,67 +26,105 @@ void enemy_data_init(){
     };
 }
 
-void enemy_animation_update(enemy* the_enemy, float delta){
+void enemy_list_init(enemy_list* enemies, int capacity){
+
+    entity_store* store = &enemies->store;
+    entity_store_init(store, capacity);
+    entity_store_add_column(store, (void**)&enemies->name, sizeof(enemy_name));
+    entity_store_add_column(store, (void**)&enemies->state, sizeof(enemy_state));
+    entity_store_add_column(store, (void**)&enemies->animation_start, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->animation_timer, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->position, sizeof(vector));
+    entity_store_add_column(store, (void**)&enemies->last_position, sizeof(vector));
+    entity_store_add_column(store, (void**)&enemies->velocity, sizeof(vector));
+    entity_store_add_column(store, (void**)&enemies->health, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->hash_entry, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->tier, sizeof(enemy_tier));
+    entity_store_add_column(store, (void**)&enemies->sees_player, sizeof(bool));
+    entity_store_add_column(store, (void**)&enemies->last_update_tick, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->step, sizeof(vector));
+    entity_store_add_column(store, (void**)&enemies->path, sizeof(path));
+    entity_store_add_column(store, (void**)&enemies->path_index, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->path_revision, sizeof(int));
+    entity_store_add_column(store, (void**)&enemies->path_job, sizeof(path_job*));
+    entity_store_add_column(store, (void**)&enemies->path_cancelled, sizeof(path_job*));
+    entity_store_add_column(store, (void**)&enemies->path_requested, sizeof(bool));
+    entity_store_add_column(store, (void**)&enemies->path_request_start, sizeof(vector));
+}
 
-    if(the_enemy->state == ENEMY_STATE_IDLE){
+void enemy_list_free(enemy_list* enemies){
 
-        the_enemy->animation_timer = 0;
-        the_enemy->current_frame = 0;
-        return;
-    }
-    if(the_enemy->state == ENEMY_STATE_KNOCKBACK){
+    for(int i = 0; i < enemies->store.count; i++){
 
-        the_enemy->current_frame = 0;
-        return;
+        path_free(&enemies->path[i]);
     }
+    entity_store_free(&enemies->store);
+}
 
-    enemy_data* the_enemy_info = &enemy_info[the_enemy->name];
-    float target_duration;
-    int max_frames;
-    if(the_enemy->state == ENEMY_STATE_MOVING){
-
-        target_duration = the_enemy_info->move_duration;
-        max_frames = the_enemy_info->move_frames;
+int enemy_list_add(enemy_list* enemies, enemy_name name, vector position){
 
-    }else{
+    int index = entity_store_push(&enemies->store);
+    if(index == -1){
 
-        target_duration = the_enemy_info->attack_duration;
-        max_frames = the_enemy_info->attack_frames;
+        return -1;
     }
-    max_frames--;
 
-    the_enemy->animation_timer += delta;
-    if(the_enemy->animation_timer >= target_duration){
+    enemies->name[index] = name;
+    enemies->state[index] = ENEMY_STATE_IDLE;
+    enemies->animation_start[index] = 0;
+    enemies->animation_timer[index] = -1;
+    enemies->position[index] = position;
+    enemies->last_position[index] = position;
+    enemies->velocity[index] = ZERO_VECTOR;
+    enemies->health[index] = 3;
+    enemies->hash_entry[index] = -1;
+    enemies->tier[index] = ENEMY_TIER_NEAR;
+    enemies->sees_player[index] = false;
+    enemies->last_update_tick[index] = 0;
+    enemies->step[index] = ZERO_VECTOR;
+    enemies->path[index] = (path){ .squares = NULL, .length = 0, .capacity = 0 };
+    enemies->path_index[index] = 0;
+    enemies->path_revision[index] = 0;
+    enemies->path_job[index] = NULL;
+    enemies->path_cancelled[index] = NULL;
+    enemies->path_requested[index] = false;
+    enemies->path_request_start[index] = ZERO_VECTOR;
+
+    return index;
+}
+
+void enemy_list_swap_remove(enemy_list* enemies, int index){
 
-        if(the_enemy->current_frame == max_frames && the_enemy->state == ENEMY_STATE_ATTACKING){
+    path_free(&enemies->path[index]);
+    entity_store_swap_remove(&enemies->store, index);
+}
 
-            the_enemy->state = ENEMY_STATE_IDLE;
-            the_enemy->velocity = ZERO_VECTOR;
-            the_enemy->current_frame = 0;
-            the_enemy->animation_timer = 0;
+int enemy_get_frame(enemy_list* enemies, int index, int now){
 
-        }else{
+    enemy_data* the_enemy_info = &enemy_info[enemies->name[index]];
+    int elapsed = now - enemies->animation_start[index];
+    if(enemies->state[index] == ENEMY_STATE_MOVING){
 
-            the_enemy->current_frame = the_enemy->current_frame == max_frames ? 0 : the_enemy->current_frame + 1;
-            the_enemy->animation_timer -= target_duration;
-        }
-    }
-}
+        return (int)(elapsed / the_enemy_info->move_duration) % the_enemy_info->move_frames;
 
-bool enemy_has_hurtbox(enemy* the_enemy){
+    }else if(enemies->state[index] == ENEMY_STATE_ATTACKING){
 
-    enemy_data* the_enemy_info = &enemy_info[the_enemy->name];
-    return the_enemy->state == ENEMY_STATE_ATTACKING && the_enemy->current_frame >= the_enemy_info->attack_danger_frame && the_enemy->current_frame < the_enemy_info->attack_safe_frame;
+        // The attack's timer ends it on the last frame, this only covers the tick before that's handled
+        int frame = (int)(elapsed / the_enemy_info->attack_duration);
+        return frame < the_enemy_info->attack_frames ? frame : the_enemy_info->attack_frames - 1;
+    }
+
+    return 0;
 }
 
-void enemy_injure(enemy* the_enemy, int damage, vector knockback, float knockback_duration){
+bool enemy_has_hurtbox(enemy_list* enemies, int index, int now){
 
-    the_enemy->health -= damage;
-    if(knockback_duration != 0){
+    if(enemies->state[index] != ENEMY_STATE_ATTACKING){
 
-        the_enemy->state = ENEMY_STATE_KNOCKBACK;
-        the_enemy->velocity = knockback;
-        the_enemy->animation_timer = knockback_duration;
-        the_enemy->current_frame = 0;
+        return false;
     }
+
+    enemy_data* the_enemy_info = &enemy_info[enemies->name[index]];
+    int frame = enemy_get_frame(enemies, index, now);
+    return frame >= the_enemy_info->attack_danger_frame && frame < the_enemy_info->attack_safe_frame;
 }
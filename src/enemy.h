@@ -1,6 +1,9 @@
 #pragma once
 
 #include "vector.h"
+#include "pathfind.h"
+#include "path_queue.h"
+#include "entity_store.h"
 
 #include <stdbool.h>
 
@@ -32,20 +35,52 @@ typedef enum enemy_state{
     ENEMY_STATE_KNOCKBACK
 } enemy_state;
 
+// How often an enemy is updated, depending on how far it is from the player and whether they can see it
+typedef enum enemy_tier{
+    ENEMY_TIER_NEAR,
+    ENEMY_TIER_MID,
+    ENEMY_TIER_FAR,
+    ENEMY_TIER_DORMANT,
+    NUM_ENEMY_TIERS
+} enemy_tier;
+
 extern enemy_data* enemy_info;
 void enemy_data_init();
 
-typedef struct enemy{
-    enemy_name name;
+// Every enemy, with each field in its own array and an enemy's index the same in all of them
+typedef struct enemy_list{
+    entity_store store;
+
+    enemy_name* name;
+    enemy_state* state;
+    int* animation_start; // when the enemy's current animation began on the state's timer wheel, frames are worked out from it when they're needed
+    int* animation_timer; // timer that ends the enemy's attack or knockback, -1 if there isn't one
+    vector* position;
+    vector* last_position; // where the enemy was before it moved this tick, used to resolve its collisions
+    vector* velocity;
+    int* health;
+    int* hash_entry; // the enemy's entry in the state's enemy_hash
+
+    // Scheduling, enemies in lower tiers skip ticks and catch up on them all at once when they are updated
+    enemy_tier* tier;
+    bool* sees_player; // from the line of sight batch cast at the enemy's last update
+    int* last_update_tick;
+    vector* step; // how far the enemy moves this tick, its velocity times the ticks since its last update on ticks it's updated and zero otherwise
+
+    // Cached path to the player, the enemy is in path[index].squares[path_index[index]]
+    path* path;
+    int* path_index;
+    int* path_revision;
+    path_job** path_job; // the path being searched for on the path queue, or NULL if there isn't one
+    path_job** path_cancelled; // a job the enemy let go of during its update, it's cancelled afterwards in enemy order
+    bool* path_requested; // set during the enemy update when a new path should be asked for, the request is made afterwards in enemy order
+    vector* path_request_start;
+} enemy_list;
 
-    enemy_state state;
-    int current_frame;
-    float animation_timer;
-    vector position;
-    vector velocity;
-    int health;
-} enemy;
+void enemy_list_init(enemy_list* enemies, int capacity);
+void enemy_list_free(enemy_list* enemies);
+int enemy_list_add(enemy_list* enemies, enemy_name name, vector position); // returns the new enemy's index, or -1 if the list is full
+void enemy_list_swap_remove(enemy_list* enemies, int index); // frees what the enemy owns and moves the last enemy into its place
 
-void enemy_animation_update(enemy* the_enemy, float delta);
-bool enemy_has_hurtbox(enemy* the_enemy);
-void enemy_injure(enemy* the_enemy, int damage, vector knockback, float knockback_duration);
+int enemy_get_frame(enemy_list* enemies, int index, int now); // returns the frame of the enemy's animation at time now
+bool enemy_has_hurtbox(enemy_list* enemies, int index, int now);
@@ -1,34 +1,75 @@
 #include "engine.h"
 #include "enemy.h"
+#include "texture_cache.h"
+#include "texture_residency.h"
+#include "span.h"
+#include "ray_packet.h"
+#include "depth_bounds.h"
 
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 
 #include <stdio.h>
 #include <stdint.h>
+#include <math.h>
 
 const int SCREEN_WIDTH = 640;
 const int SCREEN_HEIGHT = 360;
 
 float z_buffer[640];
 
+// What the wall ray for each column hit, cast a packet at a time. The distances go straight into the z_buffer
+vector wall_rays[640];
+int wall_texture_xs[640];
+bool wall_x_sideds[640];
+int wall_textures[640];
+
+depth_bounds wall_depths; // over the z_buffer, rebuilt after the wall pass
+
+// The z_buffer with the nearest sprite drawn in each column taken into account, so the splats drawn after the sprites
+// can be hidden by them too
+float sprite_z_buffer[640];
+depth_bounds sprite_depths; // over the sprite_z_buffer, rebuilt after the sprite pass
+
 uint32_t* screen_buffer;
 SDL_Texture* screen_buffer_texture;
 SDL_Surface* screen_surface;
 SDL_PixelFormat* screen_buffer_format;
 
+// The smallest box around a full size sprite's opaque texels, inclusive. first_x is past last_x if there aren't any
+typedef struct sprite_bounds{
+    int first_x;
+    int last_x;
+    int first_y;
+    int last_y;
+} sprite_bounds;
+
 typedef struct spritesheet{
     int sprite_count;
-    uint32_t** sprites;
+    int mip_levels; // 1 if the sheet only has its full size sprites
+    int sprite_stride; // texels in each sprite, counting all of its mip levels
+    uint32_t** sprites; // each sprite's texels, followed by its mip levels if it has any. NULL in indexed colour mode
+    uint32_t* atlas; // every sprite one after the other in one buffer, or NULL if they're in the cache file
+    uint8_t* indices; // in indexed colour mode every sprite's palette indices one after the other, otherwise NULL
+    sprite_bounds* bounds;
+    texture_cache* cache; // the cache file the sprites point into, or NULL if they were converted into the atlas
 } spritesheet;
 
-const int TEXTURE_SIZE = 64;
-spritesheet* texture_sprites;
-spritesheet* object_sprites;
-spritesheet* projectile_sprites;
-spritesheet** enemy_move_sprites;
-spritesheet** enemy_attack_sprites;
-spritesheet** enemy_hurt_sprites;
+const int TEXTURE_SIZE = 64; // any power of two up to 256, with the spritesheets cut to match
+int texture_shift; // log2 of TEXTURE_SIZE, for picking span kernels
+int mip_levels; // TEXTURE_SIZE wide down to 1 wide
+int mip_offsets[16]; // where each mip level starts in a sprite, and after the last one how many texels it takes altogether
+const char* TEXTURE_CACHE_DIRECTORY = "./cache";
+
+// Spritesheets are kept in the residency and referred to by their id there
+const size_t TEXTURE_BUDGET = 32 * 1024 * 1024; // bytes of spritesheets that can stay loaded once they're no longer drawn
+texture_residency* residency;
+int texture_sheet;
+int object_sheet;
+int projectile_sheet;
+int* enemy_move_sheets;
+int* enemy_attack_sheets;
+int* enemy_hurt_sheets;
 
 typedef struct anim_texture{
     SDL_Texture* texture;
@@ -44,6 +85,68 @@ bool is_fullscreen = false;
 
 TTF_Font* font_small;
 
+// Splat pass, projectiles and particles are drawn after the sorted sprites without being sorted themselves
+const float SPLAT_NEAR = 0.1; // anything closer to the camera than this isn't drawn
+const int SPLAT_MAX_SIZE = 8; // the most pixels across a particle is ever drawn
+uint32_t particle_colors[NUM_PARTICLE_KINDS];
+float* splat_depths;
+float* splat_offsets;
+int splat_capacity = 0;
+
+// Spritesheets loaded ahead of time are each a separate job on the asset pool
+typedef struct asset_load{
+    int sheet;
+    double start; // when the job began and finished on the startup timeline
+    double end;
+} asset_load;
+
+worker_pool* asset_pool;
+uint64_t startup_counter;
+double startup_setup_end; // when the window, renderer and font were ready
+double startup_assets_start; // when the first startup spritesheet began loading, and the last one finished
+double startup_assets_end;
+double startup_ready;
+
+// Sprites are drawn by the render pool, each thread taking strips of screen columns this wide
+const int SPRITE_STRIP_WIDTH = 32;
+worker_pool* render_pool;
+
+// A sprite trimmed to its opaque box and clipped to the screen, ready for the strips to draw
+typedef struct sprite_draw{
+    const uint32_t* image;
+    const uint8_t* index_image; // used instead of the image in indexed colour mode
+    const uint32_t* shade;
+    float depth;
+    bool partly_hidden; // false if it's in front of the walls in every column it covers, so they don't need checking
+    int left; // the screen column the sprite's first texel column would be at
+    int first_x; // columns and rows it covers, the last ones exclusive
+    int last_x;
+    int first_y;
+    int last_y;
+    uint32_t step; // texels per pixel in 16.16 fixed point, the same both ways
+    uint32_t texture_pos; // texel row at first_y
+} sprite_draw;
+
+typedef struct sprite_pass{
+    sprite_draw* draws; // farthest first
+    int draw_count;
+    span_column_kernel kernel;
+} sprite_pass;
+
+// Indexed colour mode
+// Textures are kept as one byte palette indices rather than 32 bit colours, and turned into colours through a light
+// table picked by distance and wall side, so fog and side shading cost one lookup. Index 0 is transparent and the
+// rest of the palette is an even cube of colours, so any colour's index can be worked out directly
+const int PALETTE_RED_LEVELS = 6;
+const int PALETTE_GREEN_LEVELS = 7;
+const int PALETTE_BLUE_LEVELS = 6;
+const int FOG_BANDS = 32; // light tables for each side, from full light up close to nearly black far away
+const float FOG_BAND_DEPTH = 0.5; // distance covered by each band
+const float FOG_SIDE_LIGHT = 0.5; // y sided walls, floors and ceilings are this much darker, like in full colour
+bool indexed_color = false;
+uint8_t palette[256][3];
+uint32_t* shade_tables; // FOG_BANDS tables of 256 colours for the lit side, then FOG_BANDS for the dark side
+
 uint32_t COLOR_TRANSPARENT;
 const SDL_Color COLOR_WHITE = (SDL_Color){ .r = 255, .g = 255, .b = 255, .a = 255 };
 
@@ -131,68 +234,393 @@ void engine_anim_texture_free(anim_texture* anim){
     free(anim);
 }
 
+void engine_build_palette(){
+
+    int index = 1;
+    for(int red = 0; red < PALETTE_RED_LEVELS; red++){
+
+        for(int green = 0; green < PALETTE_GREEN_LEVELS; green++){
+
+            for(int blue = 0; blue < PALETTE_BLUE_LEVELS; blue++){
+
+                palette[index][0] = (red * 255) / (PALETTE_RED_LEVELS - 1);
+                palette[index][1] = (green * 255) / (PALETTE_GREEN_LEVELS - 1);
+                palette[index][2] = (blue * 255) / (PALETTE_BLUE_LEVELS - 1);
+                index++;
+            }
+        }
+    }
+    for(; index < 256; index++){
+
+        palette[index][0] = 0;
+        palette[index][1] = 0;
+        palette[index][2] = 0;
+    }
+
+    shade_tables = malloc(sizeof(uint32_t) * 2 * FOG_BANDS * 256);
+    for(int side = 0; side < 2; side++){
+
+        for(int band = 0; band < FOG_BANDS; band++){
+
+            float light = (1 - (band / (float)FOG_BANDS)) * (side == 0 ? 1 : FOG_SIDE_LIGHT);
+            uint32_t* table = shade_tables + (((side * FOG_BANDS) + band) * 256);
+            table[0] = COLOR_TRANSPARENT;
+            for(int i = 1; i < 256; i++){
+
+                table[i] = SDL_MapRGBA(screen_buffer_format, palette[i][0] * light, palette[i][1] * light, palette[i][2] * light, 255);
+            }
+        }
+    }
+}
+
+// Takes a colour in the screen buffer's format, which is always ARGB8888
+uint8_t engine_palette_index(uint32_t color){
+
+    if((color >> 24) == 0){
+
+        return 0;
+    }
+
+    int red = ((((color >> 16) & 255) * (PALETTE_RED_LEVELS - 1)) + 127) / 255;
+    int green = ((((color >> 8) & 255) * (PALETTE_GREEN_LEVELS - 1)) + 127) / 255;
+    int blue = (((color & 255) * (PALETTE_BLUE_LEVELS - 1)) + 127) / 255;
+    return 1 + blue + (PALETTE_BLUE_LEVELS * (green + (PALETTE_GREEN_LEVELS * red)));
+}
+
+const uint32_t* engine_shade_table(bool dark_side, float distance){
+
+    int band = FOG_BANDS - 1;
+    if(distance < FOG_BANDS * FOG_BAND_DEPTH){
+
+        band = distance > 0 ? (int)(distance / FOG_BAND_DEPTH) : 0;
+    }
+
+    return shade_tables + (((dark_side ? FOG_BANDS : 0) + band) * 256);
+}
+
+// Frees the sprites' colours wherever they are, leaving the sprite array itself
+void engine_spritesheet_release_colors(spritesheet* sheet){
+
+    if(sheet->cache != NULL){
+
+        texture_cache_close(sheet->cache);
+        sheet->cache = NULL;
+    }
+    free(sheet->atlas);
+    sheet->atlas = NULL;
+}
+
+// Finds each sprite's opaque box, so drawing it can skip the empty columns and rows around it
+void engine_spritesheet_bounds(spritesheet* sheet){
+
+    sheet->bounds = malloc(sizeof(sprite_bounds) * sheet->sprite_count);
+    for(int i = 0; i < sheet->sprite_count; i++){
+
+        sprite_bounds bounds = (sprite_bounds){ .first_x = TEXTURE_SIZE, .last_x = -1, .first_y = TEXTURE_SIZE, .last_y = -1 };
+        for(int x = 0; x < TEXTURE_SIZE; x++){
+
+            const uint32_t* column = sheet->sprites[i] + (x << texture_shift);
+            for(int y = 0; y < TEXTURE_SIZE; y++){
+
+                if(column[y] != COLOR_TRANSPARENT){
+
+                    bounds.first_x = x < bounds.first_x ? x : bounds.first_x;
+                    bounds.last_x = x;
+                    bounds.first_y = y < bounds.first_y ? y : bounds.first_y;
+                    bounds.last_y = y > bounds.last_y ? y : bounds.last_y;
+                }
+            }
+        }
+        sheet->bounds[i] = bounds;
+    }
+}
+
+// Narrows the screen pixels first to last, exclusive, to the ones that land on texels first_texel to last_texel when
+// pixel origin is on texel 0 and each pixel moves step texels on in 16.16 fixed point
+void engine_trim_span(int origin, uint32_t step, int first_texel, int last_texel, int* first, int* last){
+
+    int trimmed_first = origin + (int)((((uint64_t)first_texel << 16) + step - 1) / step);
+    int trimmed_last = origin + (int)((((uint64_t)(last_texel + 1) << 16) + step - 1) / step);
+    *first = trimmed_first > *first ? trimmed_first : *first;
+    *last = trimmed_last < *last ? trimmed_last : *last;
+}
+
+// Swaps a loaded sheet's colours for palette indices, mip levels and all, freeing the colours
+void engine_spritesheet_index(spritesheet* sheet){
+
+    sheet->indices = malloc(sheet->sprite_stride * sheet->sprite_count);
+    for(int i = 0; i < sheet->sprite_count; i++){
+
+        uint8_t* indices = sheet->indices + (i * sheet->sprite_stride);
+        for(int j = 0; j < sheet->sprite_stride; j++){
+
+            indices[j] = engine_palette_index(sheet->sprites[i][j]);
+        }
+    }
+
+    engine_spritesheet_release_colors(sheet);
+    free(sheet->sprites);
+    sheet->sprites = NULL;
+}
+
+uint8_t* engine_sheet_indices(spritesheet* sheet, int sprite, int level){
+
+    return sheet->indices + (sprite * sheet->sprite_stride) + mip_offsets[level];
+}
+
+// Mip levels
+
+void engine_build_mip_offsets(){
+
+    mip_levels = texture_shift + 1;
+    mip_offsets[0] = 0;
+    for(int level = 0; level < mip_levels; level++){
+
+        int size = TEXTURE_SIZE >> level;
+        mip_offsets[level + 1] = mip_offsets[level] + (size * size);
+    }
+}
+
+// Averages four colours in the screen buffer's format, channel by channel
+uint32_t engine_average_colors(uint32_t a, uint32_t b, uint32_t c, uint32_t d){
+
+    uint32_t average = 0;
+    for(int shift = 0; shift < 32; shift += 8){
+
+        uint32_t sum = ((a >> shift) & 255) + ((b >> shift) & 255) + ((c >> shift) & 255) + ((d >> shift) & 255);
+        average |= ((sum + 2) / 4) << shift;
+    }
+
+    return average;
+}
+
+// Gives every sprite in the sheet a chain of mip levels, each half the size of the one before, by averaging each 2x2
+// block of the level above. The full size sprites are moved into the same buffer so each chain is in one piece
+void engine_spritesheet_mip(spritesheet* sheet){
+
+    int stride = mip_offsets[mip_levels];
+    uint32_t* mips = malloc(sizeof(uint32_t) * stride * sheet->sprite_count);
+    for(int i = 0; i < sheet->sprite_count; i++){
+
+        uint32_t* chain = mips + (i * stride);
+        memcpy(chain, sheet->sprites[i], sizeof(uint32_t) * TEXTURE_SIZE * TEXTURE_SIZE);
+        for(int level = 1; level < mip_levels; level++){
+
+            const uint32_t* source = chain + mip_offsets[level - 1];
+            uint32_t* dest = chain + mip_offsets[level];
+            int source_size = TEXTURE_SIZE >> (level - 1);
+            int size = TEXTURE_SIZE >> level;
+            for(int x = 0; x < size; x++){
+
+                for(int y = 0; y < size; y++){
+
+                    int source_index = (y * 2) + (x * 2 * source_size);
+                    dest[y + (x * size)] = engine_average_colors(source[source_index], source[source_index + 1], source[source_index + source_size], source[source_index + source_size + 1]);
+                }
+            }
+        }
+    }
+
+    engine_spritesheet_release_colors(sheet);
+    for(int i = 0; i < sheet->sprite_count; i++){
+
+        sheet->sprites[i] = mips + (i * stride);
+    }
+    sheet->atlas = mips;
+    sheet->mip_levels = mip_levels;
+    sheet->sprite_stride = stride;
+}
+
+// Picks the mip level whose texels are closest to a pixel each, from how many full size texels one pixel covers
+int engine_mip_level(spritesheet* sheet, float texels_per_pixel){
+
+    int level = 0;
+    while(level < sheet->mip_levels - 1 && texels_per_pixel >= 2){
+
+        texels_per_pixel /= 2;
+        level++;
+    }
+
+    return level;
+}
+
+// Cache files go in TEXTURE_CACHE_DIRECTORY, named after the image they were made from
+void engine_texture_cache_path(const char* image_path, char* cache_path, size_t cache_path_size){
+
+    const char* name = strrchr(image_path, '/');
+    name = name == NULL ? image_path : name + 1;
+    snprintf(cache_path, cache_path_size, "%s/%s.cache", TEXTURE_CACHE_DIRECTORY, name);
+}
+
 spritesheet* engine_spritesheet_load(const char* path){
 
-    SDL_Surface* loaded_surface = IMG_Load(path);
+    size_t source_size;
+    void* source = SDL_LoadFile(path, &source_size);
+    if(source == NULL){
+
+        printf("Unable to load spritesheet image! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+    uint64_t source_hash = texture_cache_hash(source, source_size);
+
+    char cache_path[256];
+    engine_texture_cache_path(path, cache_path, sizeof(cache_path));
+
+    // If the image hasn't changed since it was last converted, the sprites can be used straight out of the cache file
+    texture_cache* cache = texture_cache_open(cache_path, source_hash, screen_buffer_format->format, TEXTURE_SIZE);
+    if(cache != NULL){
+
+        SDL_free(source);
+
+        spritesheet* sheet = malloc(sizeof(spritesheet));
+        sheet->cache = cache;
+        sheet->indices = NULL;
+        sheet->atlas = NULL;
+        sheet->bounds = NULL;
+        sheet->mip_levels = 1;
+        sheet->sprite_stride = TEXTURE_SIZE * TEXTURE_SIZE;
+        sheet->sprite_count = cache->sprite_count;
+        sheet->sprites = malloc(sizeof(uint32_t*) * sheet->sprite_count);
+        for(int i = 0; i < sheet->sprite_count; i++){
+
+            sheet->sprites[i] = cache->texels + (i * TEXTURE_SIZE * TEXTURE_SIZE);
+        }
+
+        return sheet;
+    }
+
+    SDL_Surface* loaded_surface = IMG_Load_RW(SDL_RWFromConstMem(source, source_size), 1);
+    SDL_free(source);
     if(loaded_surface == NULL){
 
         printf("Unable to load spritesheet image! SDL Error: %s\n", IMG_GetError());
         return NULL;
     }
 
-    uint32_t* loaded_surface_pixels = loaded_surface->pixels;
-    int sprite_count_width = loaded_surface->w / TEXTURE_SIZE;
-    int sprite_count_height = loaded_surface->h / TEXTURE_SIZE;
+    // Convert the whole image to the screen buffer's format in one go, with fully transparent pixels all the same
+    // transparent colour, then cut it up into sprites
+    SDL_Surface* converted_surface = SDL_ConvertSurfaceFormat(loaded_surface, screen_buffer_format->format, 0);
+    SDL_FreeSurface(loaded_surface);
+    if(converted_surface == NULL){
+
+        printf("Unable to convert spritesheet image! SDL Error: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    uint32_t* converted_pixels = converted_surface->pixels;
+    int converted_pitch = converted_surface->pitch / sizeof(uint32_t);
+    texture_clear_transparent(converted_pixels, converted_pitch * converted_surface->h);
+
+    int sprite_count_width = converted_surface->w / TEXTURE_SIZE;
+    int sprite_count_height = converted_surface->h / TEXTURE_SIZE;
 
     spritesheet* sheet = malloc(sizeof(spritesheet));
+    sheet->cache = NULL;
+    sheet->indices = NULL;
+    sheet->bounds = NULL;
+    sheet->mip_levels = 1;
+    sheet->sprite_stride = TEXTURE_SIZE * TEXTURE_SIZE;
     sheet->sprite_count = sprite_count_width * sprite_count_height;
     sheet->sprites = malloc(sizeof(uint32_t*) * sheet->sprite_count);
 
+    // All the sprites go in one atlas, in the same order they're in the cache file
+    sheet->atlas = malloc(sizeof(uint32_t) * sheet->sprite_stride * sheet->sprite_count);
     for(int x = 0; x < sprite_count_width; x++){
 
         for(int y = 0; y < sprite_count_height; y++){
 
             int sprite_index = x + (y * sprite_count_width);
-            sheet->sprites[sprite_index] = malloc(sizeof(uint32_t) * TEXTURE_SIZE * TEXTURE_SIZE);
-
-            int source_base_x = x * TEXTURE_SIZE;
-            int source_base_y = y * TEXTURE_SIZE;
+            sheet->sprites[sprite_index] = sheet->atlas + (sprite_index * sheet->sprite_stride);
 
-            for(int tx = 0; tx < TEXTURE_SIZE; tx++){
-                for(int ty = 0; ty < TEXTURE_SIZE; ty++){
-
-                    int source_index = source_base_x + tx + ((source_base_y + ty) * loaded_surface->w);
-                    int dest_index = ty + (tx * TEXTURE_SIZE);
-
-                    uint8_t r, g, b, a;
-                    SDL_GetRGBA(loaded_surface_pixels[source_index], loaded_surface->format, &r, &g, &b, &a);
-                    sheet->sprites[sprite_index][dest_index] = a == 0 ? 0 : SDL_MapRGBA(screen_buffer_format, r, g, b, a);
-                }
-            }
+            int source_index = (x * TEXTURE_SIZE) + (y * TEXTURE_SIZE * converted_pitch);
+            texture_transpose_tile(converted_pixels + source_index, converted_pitch, sheet->sprites[sprite_index], TEXTURE_SIZE);
         }
     }
 
-    SDL_FreeSurface(loaded_surface);
+    SDL_FreeSurface(converted_surface);
+
+    // Not being able to write the cache only makes the next startup slower
+    texture_cache_write(cache_path, source_hash, screen_buffer_format->format, TEXTURE_SIZE, sheet->sprite_count, sheet->sprites);
 
     return sheet;
 }
 
 void engine_spritesheet_free(spritesheet* sheet){
 
+    engine_spritesheet_release_colors(sheet);
     free(sheet->sprites);
+    free(sheet->indices);
+    free(sheet->bounds);
     free(sheet);
 }
 
+// Startup timeline, in seconds since engine_init() began
+double engine_startup_time(){
+
+    return (double)(SDL_GetPerformanceCounter() - startup_counter) / SDL_GetPerformanceFrequency();
+}
+
+void engine_load_assets(void* data, int begin, int end){
+
+    asset_load* loads = (asset_load*)data;
+    for(int i = begin; i < end; i++){
+
+        loads[i].start = engine_startup_time();
+        texture_residency_load(residency, loads[i].sheet);
+        loads[i].end = engine_startup_time();
+    }
+}
+
+void* engine_residency_load(int id, const char* path, size_t* bytes){
+
+    spritesheet* sheet = engine_spritesheet_load(path);
+    if(sheet == NULL){
+
+        *bytes = 0;
+        return NULL;
+    }
+
+    engine_spritesheet_bounds(sheet);
+
+    // Walls, floors and ceilings are seen from far away at a steep angle, sprites aren't enough to be worth it
+    if(id == texture_sheet){
+
+        engine_spritesheet_mip(sheet);
+    }
+
+    if(indexed_color){
+
+        engine_spritesheet_index(sheet);
+        *bytes = sheet->sprite_stride * sheet->sprite_count;
+
+    }else{
+
+        *bytes = sizeof(uint32_t) * sheet->sprite_stride * sheet->sprite_count;
+    }
+    return sheet;
+}
+
+void engine_residency_unload(void* sheet){
+
+    engine_spritesheet_free((spritesheet*)sheet);
+}
+
 bool engine_init(){
 
-    if(SDL_Init(SDL_INIT_VIDEO) < 0){
+    startup_counter = SDL_GetPerformanceCounter();
 
-        printf("Unable to initialize SDL! SDL Error: %s\n", SDL_GetError());
+    // Every spritesheet is decoded and converted on the asset pool while the window and renderer are being set up,
+    // which only needs the screen buffer's pixel format and SDL_image to be ready first
+    screen_buffer_format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
+    COLOR_TRANSPARENT = SDL_MapRGBA(screen_buffer_format, 0, 0, 0, 0);
+    engine_build_palette();
+    texture_shift = span_size_shift(TEXTURE_SIZE);
+    if(texture_shift == -1){
+
+        printf("Error! There are no span kernels for %ix%i textures\n", TEXTURE_SIZE, TEXTURE_SIZE);
         return false;
     }
-
-    window = SDL_CreateWindow("Raycaster", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_PRESENTVSYNC);
+    engine_build_mip_offsets();
 
     int img_flags = IMG_INIT_PNG;
 
@@ -202,15 +630,71 @@ bool engine_init(){
         return false;
     }
 
+    residency = texture_residency_create(TEXTURE_BUDGET, engine_residency_load, engine_residency_unload);
+    texture_sheet = texture_residency_add(residency, "./res/textures.png");
+    object_sheet = texture_residency_add(residency, "./res/sprites.png");
+    projectile_sheet = texture_residency_add(residency, "./res/projectiles.png");
+
+    enemy_move_sheets = malloc(sizeof(int) * NUM_ENEMIES);
+    enemy_attack_sheets = malloc(sizeof(int) * NUM_ENEMIES);
+    enemy_hurt_sheets = malloc(sizeof(int) * NUM_ENEMIES);
+    for(int i = 0; i < NUM_ENEMIES; i++){
+
+        char enemy_path[128];
+        snprintf(enemy_path, sizeof(enemy_path), "./res/%s_move.png", enemy_info[i].name);
+        enemy_move_sheets[i] = texture_residency_add(residency, enemy_path);
+        snprintf(enemy_path, sizeof(enemy_path), "./res/%s_attack.png", enemy_info[i].name);
+        enemy_attack_sheets[i] = texture_residency_add(residency, enemy_path);
+        snprintf(enemy_path, sizeof(enemy_path), "./res/%s_hurt.png", enemy_info[i].name);
+        enemy_hurt_sheets[i] = texture_residency_add(residency, enemy_path);
+    }
+
+    // Every map needs these, enemies' sheets wait until it's known which enemies are in the state
+    asset_load startup_loads[3] = {
+        { .sheet = texture_sheet, .start = 0, .end = 0 },
+        { .sheet = object_sheet, .start = 0, .end = 0 },
+        { .sheet = projectile_sheet, .start = 0, .end = 0 }
+    };
+    int startup_load_count = 3;
+
+    int asset_threads = SDL_GetCPUCount() - 1;
+    if(asset_threads > startup_load_count){
+
+        asset_threads = startup_load_count;
+
+    }else if(asset_threads < 1){
+
+        asset_threads = 1;
+    }
+    asset_pool = worker_pool_create(asset_threads);
+    render_pool = worker_pool_create(SDL_GetCPUCount() > 1 ? SDL_GetCPUCount() - 1 : 0);
+    depth_bounds_init(&wall_depths, SCREEN_WIDTH);
+    depth_bounds_init(&sprite_depths, SCREEN_WIDTH);
+    worker_pool_start(asset_pool, engine_load_assets, startup_loads, startup_load_count, 1);
+
+    if(SDL_Init(SDL_INIT_VIDEO) < 0){
+
+        printf("Unable to initialize SDL! SDL Error: %s\n", SDL_GetError());
+
+        // The pool is still filling in the residency's entries, so it has to finish before anything can be freed
+        worker_pool_wait(asset_pool);
+        return false;
+    }
+
+    window = SDL_CreateWindow("Raycaster", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_PRESENTVSYNC);
+
     if(TTF_Init() == -1){
 
         printf("Unable to initialize SDL_ttf! SDL Error: %s\n", TTF_GetError());
+        worker_pool_wait(asset_pool);
         return false;
     }
 
     if(!window || !renderer){
 
         printf("Unable to initialize engine!\n");
+        worker_pool_wait(asset_pool);
         return false;
     }
 
@@ -218,6 +702,7 @@ bool engine_init(){
     if(font_small == NULL){
 
         printf("Unable to initialize font_small! SDL Error: %s\n", TTF_GetError());
+        worker_pool_wait(asset_pool);
         return false;
     }
 
@@ -226,56 +711,97 @@ bool engine_init(){
     screen_buffer_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, SCREEN_WIDTH, SCREEN_HEIGHT);
     SDL_SetRelativeMouseMode(SDL_TRUE);
 
-    screen_buffer_format = SDL_AllocFormat(SDL_PIXELFORMAT_ARGB8888);
-    COLOR_TRANSPARENT = SDL_MapRGBA(screen_buffer_format, 0, 0, 0, 0);
+    particle_colors[PARTICLE_BOLT_TRAIL] = SDL_MapRGBA(screen_buffer_format, 255, 120, 20, 255);
+    particle_colors[PARTICLE_BOLT_SPARK] = SDL_MapRGBA(screen_buffer_format, 255, 230, 90, 255);
+    particle_colors[PARTICLE_KINETIC] = SDL_MapRGBA(screen_buffer_format, 170, 200, 255, 255);
 
+    // Textures have to be made on the thread that owns the renderer
     player_hand_anim = engine_anim_texture_load("./res/hand.png", 128, 128, 4);
+    startup_setup_end = engine_startup_time();
 
-    texture_sprites = engine_spritesheet_load("./res/textures.png");
-    object_sprites = engine_spritesheet_load("./res/sprites.png");
-    projectile_sprites = engine_spritesheet_load("./res/projectiles.png");
+    // Help with whatever spritesheets are left, nothing can be drawn until they're all in
+    worker_pool_wait(asset_pool);
+    startup_ready = engine_startup_time();
 
-    enemy_move_sprites = malloc(sizeof(spritesheet*) * NUM_ENEMIES);
-    enemy_attack_sprites = malloc(sizeof(spritesheet*) * NUM_ENEMIES);
-    enemy_hurt_sprites = malloc(sizeof(spritesheet*) * NUM_ENEMIES);
-    for(int i = 0; i < NUM_ENEMIES; i++){
+    bool assets_loaded = true;
+    startup_assets_start = startup_ready;
+    startup_assets_end = 0;
+    for(int i = 0; i < startup_load_count; i++){
+
+        if(startup_loads[i].start < startup_assets_start){
+
+            startup_assets_start = startup_loads[i].start;
+        }
+        if(startup_loads[i].end > startup_assets_end){
+
+            startup_assets_end = startup_loads[i].end;
+        }
+        if(residency->entries[startup_loads[i].sheet].texture == NULL){
 
-        char move_path[128] = "./res/";
-        strcat(move_path, enemy_info[i].name);
-        strcat(move_path, "_move.png");
-        enemy_move_sprites[i] = engine_spritesheet_load(move_path);
+            assets_loaded = false;
+        }
+    }
 
-        char attack_path[128] = "./res/";
-        strcat(attack_path, enemy_info[i].name);
-        strcat(attack_path, "_attack.png");
-        enemy_attack_sprites[i] = engine_spritesheet_load(attack_path);
+    if(!assets_loaded){
 
-        char hurt_path[128] = "./res/";
-        strcat(hurt_path, enemy_info[i].name);
-        strcat(hurt_path, "_hurt.png");
-        enemy_hurt_sprites[i] = engine_spritesheet_load(hurt_path);
+        printf("Unable to load every spritesheet!\n");
+        return false;
     }
 
     return true;
 }
 
-void engine_quit(){
+bool engine_prefetch_state(State* state){
 
-    engine_anim_texture_free(player_hand_anim);
+    // Load the sheets of every kind of enemy in the state now, rather than stalling the frame they're first drawn on
+    bool present[NUM_ENEMIES] = { false };
+    for(int i = 0; i < state->enemies.store.count; i++){
 
-    engine_spritesheet_free(texture_sprites);
-    engine_spritesheet_free(object_sprites);
-    engine_spritesheet_free(projectile_sprites);
+        present[state->enemies.name[i]] = true;
+    }
 
+    asset_load loads[3 * NUM_ENEMIES];
+    int load_count = 0;
     for(int i = 0; i < NUM_ENEMIES; i++){
 
-        engine_spritesheet_free(enemy_move_sprites[i]);
-        engine_spritesheet_free(enemy_attack_sprites[i]);
-        engine_spritesheet_free(enemy_hurt_sprites[i]);
+        if(present[i]){
+
+            loads[load_count] = (asset_load){ .sheet = enemy_move_sheets[i], .start = 0, .end = 0 };
+            loads[load_count + 1] = (asset_load){ .sheet = enemy_attack_sheets[i], .start = 0, .end = 0 };
+            loads[load_count + 2] = (asset_load){ .sheet = enemy_hurt_sheets[i], .start = 0, .end = 0 };
+            load_count += 3;
+        }
     }
-    free(enemy_move_sprites);
-    free(enemy_attack_sprites);
-    free(enemy_hurt_sprites);
+    worker_pool_run(asset_pool, engine_load_assets, loads, load_count, 1);
+
+    for(int i = 0; i < load_count; i++){
+
+        if(residency->entries[loads[i].sheet].texture == NULL){
+
+            printf("Unable to load every spritesheet the state needs!\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void engine_quit(){
+
+    engine_anim_texture_free(player_hand_anim);
+
+    worker_pool_free(asset_pool);
+    worker_pool_free(render_pool);
+    depth_bounds_free(&wall_depths);
+    depth_bounds_free(&sprite_depths);
+    texture_residency_free(residency);
+    free(enemy_move_sheets);
+    free(enemy_attack_sheets);
+    free(enemy_hurt_sheets);
+
+    free(splat_depths);
+    free(splat_offsets);
+    free(shade_tables);
 
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
@@ -292,6 +818,13 @@ void engine_set_resolution(int width, int height){
     SDL_SetWindowPosition(window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
 }
 
+void engine_toggle_indexed_color(){
+
+    // Every loaded sheet is in the other format now, they're loaded again in the new one as they're used
+    indexed_color = !indexed_color;
+    texture_residency_unload_all(residency);
+}
+
 void engine_toggle_fullscreen(){
 
     if(is_fullscreen){
@@ -375,6 +908,29 @@ void engine_render_fps(){
     engine_render_text(ups_text, COLOR_WHITE, 0, 10);
 }
 
+// Shows how many enemies the scheduler put in each tier
+void engine_render_enemy_tiers(State* state){
+
+    char tier_text[64];
+    sprintf(tier_text, "AI: %i near %i mid %i far %i dormant", state->enemy_tier_counts[ENEMY_TIER_NEAR], state->enemy_tier_counts[ENEMY_TIER_MID], state->enemy_tier_counts[ENEMY_TIER_FAR], state->enemy_tier_counts[ENEMY_TIER_DORMANT]);
+    engine_render_text(tier_text, COLOR_WHITE, 0, 20);
+}
+
+void engine_render_texture_stats(){
+
+    char texture_text[96];
+    sprintf(texture_text, "Textures%s: %i KB, %i stalls (%.1f ms), %i evicted", indexed_color ? " (indexed)" : "", (int)(texture_residency_resident_bytes(residency) / 1024), residency->stalls, residency->stall_seconds * 1000, residency->evictions);
+    engine_render_text(texture_text, COLOR_WHITE, 0, 30);
+}
+
+// Shows how long startup took, with the window setup and the spritesheet loads that overlapped it
+void engine_render_startup_stats(){
+
+    char startup_text[96];
+    sprintf(startup_text, "Startup: setup %.1f ms, sheets %.1f - %.1f ms, ready at %.1f ms", startup_setup_end * 1000, startup_assets_start * 1000, startup_assets_end * 1000, startup_ready * 1000);
+    engine_render_text(startup_text, COLOR_WHITE, 0, 40);
+}
+
 void engine_put_pixel(int x, int y, uint8_t r, uint8_t g, uint8_t b){
 
     int index = x + (y * SCREEN_WIDTH);
@@ -406,6 +962,175 @@ void engine_render_anim_texture(anim_texture* texture, int frame, int x, int y){
     SDL_RenderCopy(renderer, texture->texture, &(texture->frame_rects[frame]), &dest_rect);
 }
 
+// Works out where a whole array of positions are relative to the camera, how far in front of it and how far across
+void engine_transform_splats(const vector* restrict positions, float* restrict depths, float* restrict offsets, int count, vector origin, vector direction, vector camera){
+
+    float inverse_determinate = 1.0 / ((camera.x * direction.y) - (direction.x * camera.y));
+    for(int i = 0; i < count; i++){
+
+        float relative_x = positions[i].x - origin.x;
+        float relative_y = positions[i].y - origin.y;
+        offsets[i] = inverse_determinate * ((direction.y * relative_x) - (direction.x * relative_y));
+        depths[i] = inverse_determinate * ((-camera.y * relative_x) + (camera.x * relative_y));
+    }
+}
+
+// Draws a full size sprite depth away from the camera, column by column as long as there isn't a wall or a sprite in
+// front of it. In indexed colour mode it's drawn at full light, since projectiles glow
+void engine_render_billboard(spritesheet* sheet, int sprite, int screen_x, float depth){
+
+    int size = (int)(SCREEN_HEIGHT / depth);
+    int start_x = screen_x - (size / 2);
+    int start_y = (SCREEN_HEIGHT / 2) - (size / 2);
+    int first_x = start_x < 0 ? 0 : start_x;
+    int last_x = start_x + size > SCREEN_WIDTH ? SCREEN_WIDTH : start_x + size;
+    int first_y = start_y < 0 ? 0 : start_y;
+    int last_y = start_y + size > SCREEN_HEIGHT ? SCREEN_HEIGHT : start_y + size;
+    uint32_t step = size > 0 ? (TEXTURE_SIZE << 16) / size : 0;
+    if(step == 0){
+
+        return;
+    }
+
+    sprite_bounds bounds = sheet->bounds[sprite];
+    engine_trim_span(start_x, step, bounds.first_x, bounds.last_x, &first_x, &last_x);
+    engine_trim_span(start_y, step, bounds.first_y, bounds.last_y, &first_y, &last_y);
+    if(first_y >= last_y || first_x >= last_x){
+
+        return;
+    }
+
+    float nearest;
+    float farthest;
+    depth_bounds_query(&sprite_depths, first_x, last_x, &nearest, &farthest);
+    if(depth >= farthest){
+
+        return;
+    }
+    bool partly_hidden = depth >= nearest;
+
+    span_column_kernel kernel = span_get_column(indexed_color ? SPAN_FOG_KEYED : SPAN_KEYED, texture_shift);
+    uint32_t start_pos = (first_y - start_y) * step;
+    for(int x = first_x; x < last_x; x++){
+
+        if(partly_hidden && depth >= sprite_z_buffer[x]){
+
+            continue;
+        }
+
+        int texture_x = ((x - start_x) * step) >> 16;
+        const void* column = indexed_color ? (const void*)(engine_sheet_indices(sheet, sprite, 0) + (texture_x << texture_shift)) : (const void*)(sheet->sprites[sprite] + (texture_x << texture_shift));
+        kernel(screen_buffer + x + (first_y * SCREEN_WIDTH), SCREEN_WIDTH, last_y - first_y, column, shade_tables, start_pos, step);
+    }
+}
+
+// Projectiles and particles are small and there can be a lot of them, so rather than going through the sorted sprite
+// path they're transformed in one batch and drawn over everything else, each only checking the depth of the nearest
+// wall or sprite in the columns it covers. A particle is a square of its kind's colour, a few pixels across at most
+void engine_render_splats(State* state){
+
+    projectile_list* projectiles = &state->projectiles;
+    particle_list* particles = &state->particles;
+
+    int needed = projectiles->store.count > particles->store.count ? projectiles->store.count : particles->store.count;
+    if(needed > splat_capacity){
+
+        splat_capacity = projectiles->store.capacity > particles->store.capacity ? projectiles->store.capacity : particles->store.capacity;
+        free(splat_depths);
+        free(splat_offsets);
+        splat_depths = malloc(sizeof(float) * splat_capacity);
+        splat_offsets = malloc(sizeof(float) * splat_capacity);
+    }
+
+    spritesheet* projectile_sprites = projectiles->store.count > 0 ? texture_residency_use(residency, projectile_sheet) : NULL;
+    int projectile_count = projectile_sprites != NULL ? projectiles->store.count : 0;
+    engine_transform_splats(projectiles->position, splat_depths, splat_offsets, projectile_count, state->player_position, state->player_direction, state->player_camera);
+    for(int i = 0; i < projectile_count; i++){
+
+        float depth = splat_depths[i];
+        if(depth > SPLAT_NEAR){
+
+            int screen_x = (int)((SCREEN_WIDTH / 2) * (1 + (splat_offsets[i] / depth)));
+            engine_render_billboard(projectile_sprites, projectiles->image[i], screen_x, depth);
+        }
+    }
+
+    engine_transform_splats(particles->position, splat_depths, splat_offsets, particles->store.count, state->player_position, state->player_direction, state->player_camera);
+    for(int i = 0; i < particles->store.count; i++){
+
+        float depth = splat_depths[i];
+        if(depth <= SPLAT_NEAR){
+
+            continue;
+        }
+
+        float scale = SCREEN_HEIGHT / depth;
+        int size = (int)(particles->size[i] * scale);
+        if(size < 1){
+
+            size = 1;
+
+        }else if(size > SPLAT_MAX_SIZE){
+
+            size = SPLAT_MAX_SIZE;
+        }
+        int start_x = (int)((SCREEN_WIDTH / 2) * (1 + (splat_offsets[i] / depth))) - (size / 2);
+        int start_y = (int)((SCREEN_HEIGHT / 2) - (particles->height[i] * scale)) - (size / 2);
+        int first_x = start_x < 0 ? 0 : start_x;
+        int last_x = start_x + size > SCREEN_WIDTH ? SCREEN_WIDTH : start_x + size;
+        int first_y = start_y < 0 ? 0 : start_y;
+        int last_y = start_y + size > SCREEN_HEIGHT ? SCREEN_HEIGHT : start_y + size;
+
+        uint32_t color = particle_colors[particles->kind[i]];
+        for(int x = first_x; x < last_x; x++){
+
+            if(depth >= sprite_z_buffer[x]){
+
+                continue;
+            }
+            for(int y = first_y; y < last_y; y++){
+
+                screen_buffer[x + (y * SCREEN_WIDTH)] = color;
+            }
+        }
+    }
+}
+
+// Draws every sprite in the pass back to front, but only the parts of them in strips begin to end - 1. Each strip
+// is its own columns of the screen buffer and sprite_z_buffer, so any number of strips can be drawn at once
+void engine_render_sprite_strips(void* data, int begin, int end){
+
+    sprite_pass* pass = (sprite_pass*)data;
+    int strip_first_x = begin * SPRITE_STRIP_WIDTH;
+    int strip_last_x = end * SPRITE_STRIP_WIDTH < SCREEN_WIDTH ? end * SPRITE_STRIP_WIDTH : SCREEN_WIDTH;
+    for(int x = strip_first_x; x < strip_last_x; x++){
+
+        sprite_z_buffer[x] = z_buffer[x];
+    }
+
+    for(int i = 0; i < pass->draw_count; i++){
+
+        const sprite_draw* draw = &pass->draws[i];
+        int first_x = draw->first_x > strip_first_x ? draw->first_x : strip_first_x;
+        int last_x = draw->last_x < strip_last_x ? draw->last_x : strip_last_x;
+        for(int x = first_x; x < last_x; x++){
+
+            if(draw->partly_hidden && draw->depth >= z_buffer[x]){
+
+                continue;
+            }
+            if(draw->depth < sprite_z_buffer[x]){
+
+                sprite_z_buffer[x] = draw->depth;
+            }
+
+            int texture_x = ((x - draw->left) * draw->step) >> 16;
+            const void* column = indexed_color ? (const void*)(draw->index_image + (texture_x << texture_shift)) : (const void*)(draw->image + (texture_x << texture_shift));
+            pass->kernel(screen_buffer + x + (draw->first_y * SCREEN_WIDTH), SCREEN_WIDTH, draw->last_y - draw->first_y, column, draw->shade, draw->texture_pos, draw->step);
+        }
+    }
+}
+
 void engine_render_state(State* state){
 
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
@@ -414,6 +1139,9 @@ void engine_render_state(State* state){
     SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
     engine_unlock_buffer();
 
+    spritesheet* texture_sprites = texture_residency_use(residency, texture_sheet);
+    spritesheet* object_sprites = texture_residency_use(residency, object_sheet);
+
     // Floor casting
     for(int y = 0; y < SCREEN_HEIGHT; y++){
 
@@ -421,28 +1149,74 @@ void engine_render_state(State* state){
         vector ray_dir1 = vector_sum(state->player_direction, state->player_camera);
 
         int p = y - (SCREEN_HEIGHT / 2);
+        if(p == 0){
+
+            continue;
+        }
         float z_pos = 0.5 * SCREEN_HEIGHT;
         float row_dist = z_pos / p;
 
         vector floor_step = vector_mult(vector_sum(ray_dir1, vector_mult(ray_dir0, -1)), row_dist / SCREEN_WIDTH);
         vector floor = vector_sum(state->player_position, vector_mult(ray_dir0, row_dist));
+        const uint32_t* shade = indexed_color ? engine_shade_table(true, fabs(row_dist)) : NULL;
+
+        // The whole row is the same distance away, so it all uses the mip level that fits how far apart its pixels land
+        int level = engine_mip_level(texture_sprites, vector_magnitude(floor_step) * TEXTURE_SIZE);
+        span_floor_kernel kernel = span_get_floor(indexed_color ? SPAN_FOG : SPAN_DARK, texture_shift - level);
+
+        // The row is walked in 16.16 fixed point and split into spans that each stay in one map cell, so each span
+        // only has to look its textures up once
+        int32_t u = (int32_t)(floor.x * 65536);
+        int32_t v = (int32_t)(floor.y * 65536);
+        int32_t du = (int32_t)(floor_step.x * 65536);
+        int32_t dv = (int32_t)(floor_step.y * 65536);
+        uint32_t* floor_row = screen_buffer + (y * SCREEN_WIDTH);
+        uint32_t* ceil_row = screen_buffer + ((SCREEN_HEIGHT - y - 1) * SCREEN_WIDTH);
+        int x = 0;
+        while(x < SCREEN_WIDTH){
+
+            int cell_x = u >> 16;
+            int cell_y = v >> 16;
+            int run = SCREEN_WIDTH - x;
+            if(du > 0){
+
+                int run_x = ((((cell_x + 1) * 65536) - u) + du - 1) / du;
+                run = run_x < run ? run_x : run;
+
+            }else if(du < 0){
+
+                int run_x = ((u - (cell_x * 65536)) / -du) + 1;
+                run = run_x < run ? run_x : run;
+            }
+            if(dv > 0){
+
+                int run_y = ((((cell_y + 1) * 65536) - v) + dv - 1) / dv;
+                run = run_y < run ? run_y : run;
 
-        for(int x = 0; x < SCREEN_WIDTH; ++x){
+            }else if(dv < 0){
 
-            vector cell = (vector){ .x = (int)floor.x, .y = (int)floor.y };
-            int texture_x = (int)(TEXTURE_SIZE * (floor.x - cell.x)) & (TEXTURE_SIZE - 1);
-            int texture_y = (int)(TEXTURE_SIZE * (floor.y - cell.y)) & (TEXTURE_SIZE - 1);
+                int run_y = ((v - (cell_y * 65536)) / -dv) + 1;
+                run = run_y < run ? run_y : run;
+            }
 
-            floor = vector_sum(floor, floor_step);
-            if(cell.x >= 0 && cell.x <= state->map->width - 1 && cell.y >= 0 && cell.y <= state->map->height - 1){
+            if(cell_x >= 0 && cell_x < state->map->width && cell_y >= 0 && cell_y < state->map->height){
 
-                int floor_index = cell.x + (cell.y * state->map->width);
-                int source_index = texture_x + (texture_y * TEXTURE_SIZE);
-                int dest_index = x + (y * SCREEN_WIDTH);
-                screen_buffer[dest_index] = (texture_sprites->sprites[state->map->floor[floor_index] - 1][source_index] >> 1) & 8355711;
-                dest_index = x + ((SCREEN_HEIGHT - y - 1) * SCREEN_WIDTH);
-                screen_buffer[dest_index] = (texture_sprites->sprites[state->map->ceil[floor_index] - 1][source_index] >> 1) & 8355711;
+                int floor_index = cell_x + (cell_y * state->map->width);
+                int floor_texture = state->map->floor[floor_index] - 1;
+                int ceil_texture = state->map->ceil[floor_index] - 1;
+                if(indexed_color){
+
+                    kernel(floor_row + x, ceil_row + x, run, engine_sheet_indices(texture_sprites, floor_texture, level), engine_sheet_indices(texture_sprites, ceil_texture, level), shade, u, v, du, dv);
+
+                }else{
+
+                    kernel(floor_row + x, ceil_row + x, run, texture_sprites->sprites[floor_texture] + mip_offsets[level], texture_sprites->sprites[ceil_texture] + mip_offsets[level], shade, u, v, du, dv);
+                }
             }
+
+            u += du * run;
+            v += dv * run;
+            x += run;
         }
     }
 
@@ -450,13 +1224,16 @@ void engine_render_state(State* state){
     for(int x = 0; x < SCREEN_WIDTH; x++){
 
         float camera_x = ((2 * x) / (float)SCREEN_WIDTH) - 1;
-        vector ray = vector_sum(state->player_direction, vector_mult(state->player_camera, camera_x));
-        float wall_dist;
-        int texture_x;
-        bool x_sided;
-        int texture;
-        render_raycast(state, state->player_position, ray, &wall_dist, &texture_x, &x_sided, &texture);
-        z_buffer[x] = wall_dist;
+        wall_rays[x] = vector_sum(state->player_direction, vector_mult(state->player_camera, camera_x));
+    }
+    render_raycast_packet(state, state->player_position, wall_rays, SCREEN_WIDTH, TEXTURE_SIZE, z_buffer, wall_texture_xs, wall_x_sideds, wall_textures);
+
+    for(int x = 0; x < SCREEN_WIDTH; x++){
+
+        float wall_dist = z_buffer[x];
+        int texture_x = wall_texture_xs[x];
+        bool x_sided = wall_x_sideds[x];
+        int texture = wall_textures[x];
 
         int line_height = (int)(SCREEN_HEIGHT / wall_dist);
         int line_start = (SCREEN_HEIGHT / 2) - (line_height / 2);
@@ -470,52 +1247,78 @@ void engine_render_state(State* state){
             line_end = SCREEN_HEIGHT - 1;
         }
 
-        float step = (1.0 * TEXTURE_SIZE) / line_height;
-        float texture_pos = (line_start - (SCREEN_HEIGHT / 2) + (line_height / 2)) * step;
-        for(int y = line_start; y < line_end; y++){
+        if(line_end <= line_start){
+
+            continue;
+        }
+
+        // Far away walls are drawn from a smaller mip level so that the column steps through its texels about one at a time
+        int level = engine_mip_level(texture_sprites, (TEXTURE_SIZE * wall_dist) / SCREEN_HEIGHT);
+        int shift = texture_shift - level;
+        int mip_x = texture_x >> level;
+
+        uint32_t step = (1u << (shift + 16)) / line_height;
+        uint32_t texture_pos = (line_start - (SCREEN_HEIGHT / 2) + (line_height / 2)) * step;
+        uint32_t* dest = screen_buffer + x + (line_start * SCREEN_WIDTH);
+        if(indexed_color){
+
+            const uint8_t* column = engine_sheet_indices(texture_sprites, texture - 1, level) + (mip_x << shift);
+            span_get_column(SPAN_FOG, shift)(dest, SCREEN_WIDTH, line_end - line_start, column, engine_shade_table(!x_sided, wall_dist), texture_pos, step);
+
+        }else{
 
-            int texture_y = (int)texture_pos & (TEXTURE_SIZE - 1);
-            texture_pos += step;
-            int source_index = texture_y + (texture_x * TEXTURE_SIZE);
-            int dest_index = x + (y * SCREEN_WIDTH);
-            screen_buffer[dest_index] = x_sided ? texture_sprites->sprites[texture - 1][source_index] : (texture_sprites->sprites[texture - 1][source_index] >> 1) & 8355711;
+            const uint32_t* column = texture_sprites->sprites[texture - 1] + mip_offsets[level] + (mip_x << shift);
+            span_get_column(x_sided ? SPAN_LIT : SPAN_DARK, shift)(dest, SCREEN_WIDTH, line_end - line_start, column, NULL, texture_pos, step);
         }
     }
 
+    depth_bounds_build(&wall_depths, z_buffer);
+
     // Sprite casting
 
     // First collect sprite info from all the different kinds of sprite arrays
     // This is done because it's easier from a game-logic perspective to store the sprites in separate arrays rather than carrying a tag on each sprite
-    int sprite_count = state->object_count + state->projectile_count + state->enemy_count;
+    int enemy_count = state->enemies.store.count;
+    int sprite_count = state->object_count + enemy_count;
     vector** sprite_positions = malloc(sizeof(vector*) * sprite_count);
     uint32_t** sprite_images = malloc(sizeof(uint32_t*) * sprite_count);
+    uint8_t** sprite_indices = malloc(sizeof(uint8_t*) * sprite_count); // used instead of the images in indexed colour mode
+    sprite_bounds* sprite_boxes = malloc(sizeof(sprite_bounds) * sprite_count);
     float** sprite_distances = (float**)malloc(sizeof(float*) * sprite_count);
     for(int i = 0; i < state->object_count; i++){
 
         sprite_positions[i] = &(state->objects[i].position);
-        sprite_images[i] = object_sprites->sprites[state->objects[i].image];
+        sprite_images[i] = indexed_color ? NULL : object_sprites->sprites[state->objects[i].image];
+        sprite_indices[i] = indexed_color ? engine_sheet_indices(object_sprites, state->objects[i].image, 0) : NULL;
+        sprite_boxes[i] = object_sprites->bounds[state->objects[i].image];
     }
     int base_index = state->object_count;
-    for(int i = 0; i < state->projectile_count; i++){
-
-        sprite_positions[i + base_index] = &(state->projectiles[i].position);
-        sprite_images[i + base_index] = projectile_sprites->sprites[state->projectiles[i].image];
-    }
-    base_index += state->projectile_count;
-    for(int i = 0; i < state->enemy_count; i++){
+    enemy_list* enemies = &state->enemies;
+    for(int i = 0; i < enemy_count; i++){
 
-        sprite_positions[i + base_index] = &(state->enemies[i].position);
-        if(state->enemies[i].state == ENEMY_STATE_KNOCKBACK){
+        sprite_positions[i + base_index] = &(enemies->position[i]);
+        int sheet;
+        if(enemies->state[i] == ENEMY_STATE_KNOCKBACK){
 
-            sprite_images[i + base_index] = enemy_hurt_sprites[state->enemies[i].name]->sprites[state->enemies[i].current_frame];
+            sheet = enemy_hurt_sheets[enemies->name[i]];
 
-        }else if(state->enemies[i].state == ENEMY_STATE_ATTACKING){
+        }else if(enemies->state[i] == ENEMY_STATE_ATTACKING){
 
-            sprite_images[i + base_index] = enemy_attack_sprites[state->enemies[i].name]->sprites[state->enemies[i].current_frame];
+            sheet = enemy_attack_sheets[enemies->name[i]];
 
         }else{
 
-            sprite_images[i + base_index] = enemy_move_sprites[state->enemies[i].name]->sprites[state->enemies[i].current_frame];
+            sheet = enemy_move_sheets[enemies->name[i]];
+        }
+
+        // A sheet that couldn't be loaded leaves the enemy invisible
+        spritesheet* enemy_sprites = texture_residency_use(residency, sheet);
+        int frame = enemy_get_frame(enemies, i, state->timers->now);
+        sprite_images[i + base_index] = enemy_sprites != NULL && !indexed_color ? enemy_sprites->sprites[frame] : NULL;
+        sprite_indices[i + base_index] = enemy_sprites != NULL && indexed_color ? engine_sheet_indices(enemy_sprites, frame, 0) : NULL;
+        if(enemy_sprites != NULL){
+
+            sprite_boxes[i + base_index] = enemy_sprites->bounds[frame];
         }
     }
     for(int i = 0; i < sprite_count; i++){
@@ -529,7 +1332,13 @@ void engine_render_state(State* state){
     quicksort(sprite_distances, 0, sprite_count - 1);
 
     vector minus_player_pos = vector_mult(state->player_position, -1);
-    // Lastly render the sprites in order from farthest to nearest
+    // Lastly work out where each sprite goes on screen in order from farthest to nearest, then have the render pool draw
+    // them strip by strip
+    sprite_pass pass = (sprite_pass){
+        .draws = malloc(sizeof(sprite_draw) * sprite_count),
+        .draw_count = 0,
+        .kernel = span_get_column(indexed_color ? SPAN_FOG_KEYED : SPAN_KEYED, texture_shift)
+    };
     for(int i = sprite_count - 1; i >= 0; i--){
 
         vector sprite_render_pos = vector_sum(*(sprite_positions[(int)sprite_distances[i][0]]), minus_player_pos);
@@ -563,43 +1372,87 @@ void engine_render_state(State* state){
         }
 
         uint32_t* sprite_image = sprite_images[(int)sprite_distances[i][0]];
-        // SDL_Rect region = object_sprite_regions[sprite_index];
-        for(int stripe = sprite_start_x; stripe < sprite_end_x; stripe++){
+        uint8_t* sprite_index_image = sprite_indices[(int)sprite_distances[i][0]];
+        if(sprite_image == NULL && sprite_index_image == NULL){
 
-            int texture_x = (int)((stripe - (sprite_screen_x - (sprite_width / 2))) * TEXTURE_SIZE / sprite_width);
-            if(transform.y > 0 && stripe > 0 && stripe < SCREEN_WIDTH && transform.y < z_buffer[stripe]){
+            continue;
+        }
+        uint32_t step = sprite_height > 0 ? (TEXTURE_SIZE << 16) / sprite_height : 0;
+        if(transform.y <= 0 || step == 0){
 
-                for(int y = sprite_start_y; y < sprite_end_y; y++){
+            continue;
+        }
 
-                    int d = y - (SCREEN_HEIGHT / 2) + (sprite_height / 2);
-                    int texture_y = (int)((d * TEXTURE_SIZE) / sprite_height);
-                    int source_index = texture_y + (texture_x * TEXTURE_SIZE);
-                    int dest_index = stripe + (y * SCREEN_WIDTH);
-                    uint32_t color = sprite_image[source_index];
-                    if(color != COLOR_TRANSPARENT){
+        // Only the columns and rows that land on the sprite's opaque box are drawn
+        int sprite_left = sprite_screen_x - (sprite_width / 2);
+        int sprite_top = (SCREEN_HEIGHT / 2) - (sprite_height / 2);
+        sprite_bounds bounds = sprite_boxes[(int)sprite_distances[i][0]];
+        engine_trim_span(sprite_left, step, bounds.first_x, bounds.last_x, &sprite_start_x, &sprite_end_x);
+        engine_trim_span(sprite_top, step, bounds.first_y, bounds.last_y, &sprite_start_y, &sprite_end_y);
+        if(sprite_start_x < 1){
 
-                        screen_buffer[dest_index] = color;
-                    }
-                } // End for each sprite y
-            }
-        } // End for each stripe
+            sprite_start_x = 1;
+        }
+        if(sprite_end_y <= sprite_start_y || sprite_end_x <= sprite_start_x){
+
+            continue;
+        }
+
+        // A sprite behind the farthest wall it covers can't be seen at all
+        float nearest_wall;
+        float farthest_wall;
+        depth_bounds_query(&wall_depths, sprite_start_x, sprite_end_x, &nearest_wall, &farthest_wall);
+        if(transform.y >= farthest_wall){
+
+            continue;
+        }
+
+        pass.draws[pass.draw_count] = (sprite_draw){
+            .image = sprite_image,
+            .index_image = sprite_index_image,
+            .shade = indexed_color ? engine_shade_table(false, transform.y) : NULL,
+            .depth = transform.y,
+            .partly_hidden = transform.y >= nearest_wall,
+            .left = sprite_left,
+            .first_x = sprite_start_x,
+            .last_x = sprite_end_x,
+            .first_y = sprite_start_y,
+            .last_y = sprite_end_y,
+            .step = step,
+            .texture_pos = (sprite_start_y - sprite_top) * step
+        };
+        pass.draw_count++;
     } // End for each sprite
 
+    int strip_count = (SCREEN_WIDTH + SPRITE_STRIP_WIDTH - 1) / SPRITE_STRIP_WIDTH;
+    worker_pool_run(render_pool, engine_render_sprite_strips, &pass, strip_count, 1);
+    depth_bounds_build(&sprite_depths, sprite_z_buffer);
+
     // Clean memory from sprite casting
+    free(pass.draws);
     free(sprite_positions);
     free(sprite_images);
+    free(sprite_indices);
+    free(sprite_boxes);
     for(int i = 0; i < sprite_count; i++){
 
         free(sprite_distances[i]);
     }
     free(sprite_distances);
 
+    engine_render_splats(state);
+
     engine_render_buffer();
 
     // Render UI
     vector player_animation_offset = player_get_animation_offset(state);
-    engine_render_anim_texture(player_hand_anim, state->player_animation_frame, SCREEN_WIDTH - 160 + (int)player_animation_offset.x, SCREEN_HEIGHT - 128 + (int)player_animation_offset.y);
+    engine_render_anim_texture(player_hand_anim, player_get_animation_frame(state), SCREEN_WIDTH - 160 + (int)player_animation_offset.x, SCREEN_HEIGHT - 128 + (int)player_animation_offset.y);
 
     engine_render_fps();
+    engine_render_enemy_tiers(state);
+    engine_render_texture_stats();
+    engine_render_startup_stats();
     SDL_RenderPresent(renderer);
+
+    texture_residency_end_frame(residency);
 }
@@ -8,10 +8,12 @@ extern const int SCREEN_WIDTH;
 extern const int SCEEN_HEIGHT;
 
 bool engine_init();
+bool engine_prefetch_state(State* state); // loads the textures the state's enemies need before they're first drawn
 void engine_quit();
 
 void engine_set_resolution(int width, int height);
 void engine_toggle_fullscreen();
+void engine_toggle_indexed_color(); // switches textures between 32 bit colour and palette indices shaded with distance fog
 
 void engine_clock_init();
 float engine_clock_tick();
@@ -0,0 +1,185 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "entity_store.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+// Field arrays are aligned for the widest vector registers we might want to run the entity loops on
+const size_t ENTITY_STORE_ALIGNMENT = 32;
+
+const entity_handle NULL_HANDLE = (entity_handle){ .slot = -1, .generation = 0 };
+
+void entity_store_init(entity_store* store, int capacity){
+
+    store->count = 0;
+    store->capacity = capacity;
+
+    store->column_count = 0;
+    store->column_capacity = 8;
+    store->columns = malloc(sizeof(void**) * store->column_capacity);
+    store->column_sizes = malloc(sizeof(size_t) * store->column_capacity);
+
+    entity_store_add_column(store, (void**)&store->slots, sizeof(int));
+    store->slot_indices = malloc(sizeof(int) * capacity);
+    store->slot_generations = malloc(sizeof(int) * capacity);
+    store->free_slots = malloc(sizeof(int) * capacity);
+
+    // The free slots are taken from the back, so this hands out the low ones first
+    for(int i = 0; i < capacity; i++){
+
+        store->slot_indices[i] = -1;
+        store->slot_generations[i] = 0;
+        store->free_slots[i] = capacity - 1 - i;
+    }
+    store->free_slot_count = capacity;
+
+    store->removal_count = 0;
+    store->removals = malloc(sizeof(int) * capacity);
+    store->removals_sorted = true;
+    store->slot_removal_queued = calloc(capacity, sizeof(bool));
+}
+
+void entity_store_free(entity_store* store){
+
+    for(int i = 0; i < store->column_count; i++){
+
+        free(*store->columns[i]);
+        *store->columns[i] = NULL;
+    }
+    free(store->columns);
+    free(store->column_sizes);
+    free(store->slot_indices);
+    free(store->slot_generations);
+    free(store->free_slots);
+    free(store->removals);
+    free(store->slot_removal_queued);
+}
+
+void entity_store_add_column(entity_store* store, void** column, size_t unit_size){
+
+    if(store->column_count == store->column_capacity){
+
+        store->column_capacity *= 2;
+        store->columns = realloc(store->columns, sizeof(void**) * store->column_capacity);
+        store->column_sizes = realloc(store->column_sizes, sizeof(size_t) * store->column_capacity);
+    }
+    store->columns[store->column_count] = column;
+    store->column_sizes[store->column_count] = unit_size;
+    store->column_count++;
+
+    if(posix_memalign(column, ENTITY_STORE_ALIGNMENT, unit_size * store->capacity) != 0){
+
+        printf("Error! Couldn't allocate an entity column of %i entities\n", store->capacity);
+        *column = NULL;
+    }
+}
+
+int entity_store_push(entity_store* store){
+
+    if(store->count == store->capacity){
+
+        return -1;
+    }
+
+    int index = store->count;
+    store->free_slot_count--;
+    int slot = store->free_slots[store->free_slot_count];
+    store->slots[index] = slot;
+    store->slot_indices[slot] = index;
+    store->count++;
+
+    return index;
+}
+
+void entity_store_remove(entity_store* store, int index){
+
+    int slot = store->slots[index];
+    if(store->slot_removal_queued[slot]){
+
+        return;
+    }
+
+    store->slot_removal_queued[slot] = true;
+    store->removals[store->removal_count] = index;
+    store->removal_count++;
+    store->removals_sorted = false;
+}
+
+static int compare_indices(const void* a, const void* b){
+
+    return *(const int*)a - *(const int*)b;
+}
+
+int entity_store_pop_removal(entity_store* store){
+
+    if(store->removal_count == 0){
+
+        return -1;
+    }
+
+    // Removals are carried out from the back so that none of them moves another one that's still queued
+    if(!store->removals_sorted){
+
+        qsort(store->removals, store->removal_count, sizeof(int), compare_indices);
+        store->removals_sorted = true;
+    }
+
+    store->removal_count--;
+    int index = store->removals[store->removal_count];
+    store->slot_removal_queued[store->slots[index]] = false;
+
+    return index;
+}
+
+bool entity_store_swap_remove(entity_store* store, int index){
+
+    // Retire the slot so that any handles still pointing at it go stale
+    int slot = store->slots[index];
+    store->slot_indices[slot] = -1;
+    store->slot_generations[slot]++;
+    store->free_slots[store->free_slot_count] = slot;
+    store->free_slot_count++;
+
+    store->count--;
+    if(index == store->count){
+
+        return false;
+    }
+
+    for(int i = 0; i < store->column_count; i++){
+
+        char* column = *store->columns[i];
+        size_t unit_size = store->column_sizes[i];
+        memcpy(column + (unit_size * index), column + (unit_size * store->count), unit_size);
+    }
+    store->slot_indices[store->slots[index]] = index;
+
+    return true;
+}
+
+entity_handle entity_store_handle(entity_store* store, int index){
+
+    int slot = store->slots[index];
+    return (entity_handle){ .slot = slot, .generation = store->slot_generations[slot] };
+}
+
+int entity_store_lookup(entity_store* store, entity_handle handle){
+
+    if(handle.slot < 0 || handle.slot >= store->capacity || store->slot_generations[handle.slot] != handle.generation){
+
+        return -1;
+    }
+
+    return store->slot_indices[handle.slot];
+}
+
+void entity_integrate(vector* restrict positions, const vector* restrict velocities, int count){
+
+    for(int i = 0; i < count; i++){
+
+        positions[i].x += velocities[i].x;
+        positions[i].y += velocities[i].y;
+    }
+}
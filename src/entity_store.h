@@ -0,0 +1,67 @@
+#pragma once
+
+#include "vector.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Keeps every field of a kind of entity in its own array (struct of arrays), so that a loop that only needs
+ * positions and velocities only has to read positions and velocities
+ *
+ * The owner declares a typed pointer for each field and registers its address as a column. Every column is allocated
+ * at the store's full capacity up front and never reallocated, so pointers into them stay good for the whole tick.
+ * The arrays are always packed, an entity is removed by moving the last one into its place, so indices only stay the
+ * same until the next removal
+ *
+ * Anything that needs to refer to an entity for longer than that should keep a handle instead. A handle names a slot
+ * that follows the entity wherever it moves in the arrays, and the slot's generation goes up every time an entity in
+ * it is removed, so a handle to a removed entity is recognised as stale even once its slot has been reused
+ *
+ * Removals are queued with entity_store_remove() during a tick and carried out afterwards, last index first, by
+ * popping them with entity_store_pop_removal() and calling entity_store_swap_remove() on each one. Queueing is O(1),
+ * the queue is sorted once when the first removal is popped
+ */
+
+typedef struct entity_handle{
+    int slot;
+    int generation;
+} entity_handle;
+
+extern const entity_handle NULL_HANDLE;
+
+typedef struct entity_store{
+    int count;
+    int capacity;
+
+    void*** columns; // addresses of the owner's field pointers
+    size_t* column_sizes;
+    int column_count;
+    int column_capacity;
+
+    // Handles
+    int* slots; // the slot of each entity, kept as a column so it moves along with it
+    int* slot_indices; // where each slot's entity is in the arrays, -1 if the slot is free
+    int* slot_generations;
+    int* free_slots;
+    int free_slot_count;
+
+    int* removals; // queued indices without repeats, room is kept for the whole capacity
+    int removal_count;
+    bool removals_sorted; // ascending, once popping has started
+    bool* slot_removal_queued; // so an entity queued twice in a tick is only removed once
+} entity_store;
+
+void entity_store_init(entity_store* store, int capacity);
+void entity_store_free(entity_store* store); // frees the field arrays too
+void entity_store_add_column(entity_store* store, void** column, size_t unit_size);
+
+int entity_store_push(entity_store* store); // takes a free slot and returns the new entity's index, or -1 if the store is full. Its fields are left for the caller to fill in
+void entity_store_remove(entity_store* store, int index); // queues the entity to be removed at the end of the tick
+int entity_store_pop_removal(entity_store* store); // returns the highest queued index, or -1 if there are none left
+bool entity_store_swap_remove(entity_store* store, int index); // returns true if the last entity was moved into index
+
+entity_handle entity_store_handle(entity_store* store, int index);
+int entity_store_lookup(entity_store* store, entity_handle handle); // returns the entity's current index, or -1 if it's been removed
+
+void entity_integrate(vector* restrict positions, const vector* restrict velocities, int count); // adds every velocity to its position
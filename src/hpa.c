@@ -0,0 +1,739 @@
+#include "hpa.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+const int HPA_CLUSTER_SIZE = 16;
+const int HPA_LONG_ENTRANCE = 6; // entrances at least this wide get a node pair at each end instead of one in the middle
+
+static const int direction_x[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int direction_y[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+// Nodes
+
+static void ensure_node_capacity(hpa_graph* graph){
+
+    if(graph->node_count < graph->node_capacity){
+
+        return;
+    }
+
+    graph->node_capacity *= 2;
+    graph->nodes = realloc(graph->nodes, sizeof(hpa_node) * graph->node_capacity);
+    graph->free_nodes = realloc(graph->free_nodes, sizeof(int) * graph->node_capacity);
+}
+
+// Note that this can move graph->nodes, so don't hold onto node pointers across it
+static int node_create(hpa_graph* graph, int square, int cluster, int border){
+
+    int index;
+    if(graph->free_node_count != 0){
+
+        graph->free_node_count--;
+        index = graph->free_nodes[graph->free_node_count];
+
+    }else{
+
+        ensure_node_capacity(graph);
+        index = graph->node_count;
+        graph->node_count++;
+        graph->nodes[index].edges = NULL;
+        graph->nodes[index].edge_capacity = 0;
+    }
+
+    graph->nodes[index].square = square;
+    graph->nodes[index].cluster = cluster;
+    graph->nodes[index].border = border;
+    graph->nodes[index].edge_count = 0;
+
+    return index;
+}
+
+// Edge memory is kept around for when the slot gets reused
+static void node_destroy(hpa_graph* graph, int index){
+
+    graph->nodes[index].square = -1;
+    graph->nodes[index].edge_count = 0;
+    graph->free_nodes[graph->free_node_count] = index;
+    graph->free_node_count++;
+}
+
+static void edge_push(hpa_edge** edges, int* count, int* capacity, int to, int cost){
+
+    if(*count == *capacity){
+
+        *capacity = *capacity == 0 ? 4 : *capacity * 2;
+        *edges = realloc(*edges, sizeof(hpa_edge) * *capacity);
+    }
+
+    (*edges)[*count] = (hpa_edge){ .node = to, .cost = cost };
+    (*count)++;
+}
+
+static void node_add_edge(hpa_graph* graph, int from, int to, int cost){
+
+    hpa_node* node = &graph->nodes[from];
+    edge_push(&node->edges, &node->edge_count, &node->edge_capacity, to, cost);
+}
+
+// Clusters
+
+static int cluster_at(hpa_graph* graph, int square){
+
+    int x = square % graph->map->width;
+    int y = square / graph->map->width;
+
+    return (x / graph->cluster_size) + ((y / graph->cluster_size) * graph->clusters_wide);
+}
+
+static int cluster_local_index(hpa_graph* graph, hpa_cluster* cluster, int square){
+
+    int x = (square % graph->map->width) - cluster->x;
+    int y = (square / graph->map->width) - cluster->y;
+
+    return x + (y * cluster->width);
+}
+
+static void cluster_add_node(hpa_cluster* cluster, int node){
+
+    if(cluster->node_count == cluster->node_capacity){
+
+        cluster->node_capacity = cluster->node_capacity == 0 ? 8 : cluster->node_capacity * 2;
+        cluster->nodes = realloc(cluster->nodes, sizeof(int) * cluster->node_capacity);
+    }
+
+    cluster->nodes[cluster->node_count] = node;
+    cluster->node_count++;
+}
+
+// Breadth first search from square that never leaves the cluster
+// Afterwards the search's local_distance holds the number of moves to each square in the cluster or -1 if it couldn't
+// be reached, and following local_parent from any reached square leads back to the one searched from
+static void cluster_search(hpa_graph* graph, hpa_search* search, hpa_cluster* cluster, int square){
+
+    map* the_map = graph->map;
+    int local_size = cluster->width * cluster->height;
+    for(int i = 0; i < local_size; i++){
+
+        search->local_distance[i] = -1;
+    }
+
+    int start = cluster_local_index(graph, cluster, square);
+    search->local_distance[start] = 0;
+    search->local_parent[start] = -1;
+    search->local_queue[0] = start;
+    int queue_head = 0;
+    int queue_tail = 1;
+
+    while(queue_head != queue_tail){
+
+        int current = search->local_queue[queue_head];
+        queue_head++;
+        search->nodes_expanded++;
+
+        int current_x = current % cluster->width;
+        int current_y = current / cluster->width;
+        for(int direction = 0; direction < 8; direction++){
+
+            int child_x = current_x + direction_x[direction];
+            int child_y = current_y + direction_y[direction];
+            if(child_x < 0 || child_x >= cluster->width || child_y < 0 || child_y >= cluster->height){
+
+                continue;
+            }
+            if(!pathfind_move_allowed(the_map, cluster->x + current_x, cluster->y + current_y, direction_x[direction], direction_y[direction])){
+
+                continue;
+            }
+
+            int child = child_x + (child_y * cluster->width);
+            if(search->local_distance[child] == -1){
+
+                search->local_distance[child] = search->local_distance[current] + 1;
+                search->local_parent[child] = current;
+                search->local_queue[queue_tail] = child;
+                queue_tail++;
+            }
+        }
+    }
+}
+
+// Recalculates the edges between the nodes inside a cluster, leaving the edges that cross its borders alone
+static void cluster_link_nodes(hpa_graph* graph, int cluster_index){
+
+    hpa_cluster* cluster = &graph->clusters[cluster_index];
+
+    // Every node's first edge is the one across the border to its pair, so that's the only one to keep
+    for(int i = 0; i < cluster->node_count; i++){
+
+        graph->nodes[cluster->nodes[i]].edge_count = 1;
+    }
+
+    for(int i = 0; i < cluster->node_count; i++){
+
+        cluster_search(graph, graph->search, cluster, graph->nodes[cluster->nodes[i]].square);
+        for(int j = 0; j < cluster->node_count; j++){
+
+            int distance = graph->search->local_distance[cluster_local_index(graph, cluster, graph->nodes[cluster->nodes[j]].square)];
+            if(i != j && distance != -1){
+
+                node_add_edge(graph, cluster->nodes[i], cluster->nodes[j], distance);
+            }
+        }
+    }
+}
+
+// Borders
+
+static void border_add_transition(hpa_graph* graph, int cluster_index, int other_index, int border, int square, int other_square){
+
+    int node = node_create(graph, square, cluster_index, border);
+    int other_node = node_create(graph, other_square, other_index, border);
+    node_add_edge(graph, node, other_node, 1);
+    node_add_edge(graph, other_node, node, 1);
+    cluster_add_node(&graph->clusters[cluster_index], node);
+    cluster_add_node(&graph->clusters[other_index], other_node);
+}
+
+// Finds the entrances along the right (side 0) or bottom (side 1) border of a cluster
+static void border_build(hpa_graph* graph, int cluster_index, int side){
+
+    map* the_map = graph->map;
+    hpa_cluster* cluster = &graph->clusters[cluster_index];
+    int other_index = side == 0 ? cluster_index + 1 : cluster_index + graph->clusters_wide;
+    int border = (cluster_index * 2) + side;
+    int length = side == 0 ? cluster->height : cluster->width;
+    int step = side == 0 ? the_map->width : 1;
+    int first_square = side == 0 ? (cluster->x + cluster->width - 1) + (cluster->y * the_map->width) : cluster->x + ((cluster->y + cluster->height - 1) * the_map->width);
+    int across = side == 0 ? 1 : the_map->width;
+
+    int run_start = -1;
+    for(int i = 0; i <= length; i++){
+
+        int square = first_square + (i * step);
+        bool open = i < length && !the_map->collidemap[square] && !the_map->collidemap[square + across];
+        if(open && run_start == -1){
+
+            run_start = i;
+
+        }else if(!open && run_start != -1){
+
+            int run_length = i - run_start;
+            if(run_length >= HPA_LONG_ENTRANCE){
+
+                int first = first_square + (run_start * step);
+                int last = first_square + ((i - 1) * step);
+                border_add_transition(graph, cluster_index, other_index, border, first, first + across);
+                border_add_transition(graph, cluster_index, other_index, border, last, last + across);
+
+            }else{
+
+                int middle = first_square + ((run_start + (run_length / 2)) * step);
+                border_add_transition(graph, cluster_index, other_index, border, middle, middle + across);
+            }
+            run_start = -1;
+        }
+    }
+}
+
+static void border_remove_nodes(hpa_graph* graph, int cluster_index, int border){
+
+    hpa_cluster* cluster = &graph->clusters[cluster_index];
+    for(int i = cluster->node_count - 1; i >= 0; i--){
+
+        if(graph->nodes[cluster->nodes[i]].border == border){
+
+            node_destroy(graph, cluster->nodes[i]);
+            cluster->node_count--;
+            cluster->nodes[i] = cluster->nodes[cluster->node_count];
+        }
+    }
+}
+
+static void border_rebuild(hpa_graph* graph, int cluster_index, int side){
+
+    int other_index = side == 0 ? cluster_index + 1 : cluster_index + graph->clusters_wide;
+    int border = (cluster_index * 2) + side;
+    border_remove_nodes(graph, cluster_index, border);
+    border_remove_nodes(graph, other_index, border);
+    border_build(graph, cluster_index, side);
+}
+
+// Graph search
+
+// The start and goal only exist in the search, as the two nodes after the graph's own
+static int search_node_square(hpa_graph* graph, hpa_search* search, int node){
+
+    if(node == search->start_node){
+
+        return search->start_square;
+
+    }else if(node == search->goal_node){
+
+        return search->goal_square;
+    }
+
+    return graph->nodes[node].square;
+}
+
+static int search_node_cluster(hpa_graph* graph, hpa_search* search, int node){
+
+    if(node == search->start_node){
+
+        return search->start_cluster;
+
+    }else if(node == search->goal_node){
+
+        return search->goal_cluster;
+    }
+
+    return graph->nodes[node].cluster;
+}
+
+static int graph_heuristic(hpa_graph* graph, hpa_search* search, int node){
+
+    int width = graph->map->width;
+    int square = search_node_square(graph, search, node);
+    int dx = abs((square % width) - (search->goal_square % width));
+    int dy = abs((square / width) - (search->goal_square / width));
+
+    return dx > dy ? dx : dy;
+}
+
+static bool open_before(hpa_graph* graph, hpa_search* search, int a, int b){
+
+    int score_a = search->cost[a] + graph_heuristic(graph, search, a);
+    int score_b = search->cost[b] + graph_heuristic(graph, search, b);
+    if(score_a != score_b){
+
+        return score_a < score_b;
+    }
+
+    return search->cost[a] > search->cost[b];
+}
+
+static void open_swap(hpa_search* search, int i, int j){
+
+    int temp = search->open[i];
+    search->open[i] = search->open[j];
+    search->open[j] = temp;
+    search->open_index[search->open[i]] = i;
+    search->open_index[search->open[j]] = j;
+}
+
+static void open_sift_up(hpa_graph* graph, hpa_search* search, int i){
+
+    while(i > 0){
+
+        int parent = (i - 1) / 2;
+        if(!open_before(graph, search, search->open[i], search->open[parent])){
+
+            break;
+        }
+        open_swap(search, i, parent);
+        i = parent;
+    }
+}
+
+static void open_sift_down(hpa_graph* graph, hpa_search* search, int i){
+
+    while(true){
+
+        int left = (i * 2) + 1;
+        int right = left + 1;
+        int smallest = i;
+        if(left < search->open_size && open_before(graph, search, search->open[left], search->open[smallest])){
+
+            smallest = left;
+        }
+        if(right < search->open_size && open_before(graph, search, search->open[right], search->open[smallest])){
+
+            smallest = right;
+        }
+        if(smallest == i){
+
+            break;
+        }
+        open_swap(search, i, smallest);
+        i = smallest;
+    }
+}
+
+static void graph_relax(hpa_graph* graph, hpa_search* search, int current, int child, int cost){
+
+    int child_cost = search->cost[current] + cost;
+    if(search->seen[child] != search->generation){
+
+        search->seen[child] = search->generation;
+        search->cost[child] = child_cost;
+        search->parent[child] = current;
+        search->open[search->open_size] = child;
+        search->open_index[child] = search->open_size;
+        search->open_size++;
+        open_sift_up(graph, search, search->open_size - 1);
+
+    }else if(search->open_index[child] != -1 && child_cost < search->cost[child]){
+
+        search->cost[child] = child_cost;
+        search->parent[child] = current;
+        open_sift_up(graph, search, search->open_index[child]);
+    }
+}
+
+static bool graph_search(hpa_graph* graph, hpa_search* search){
+
+    int start = search->start_node;
+    int goal = search->goal_node;
+    search->generation++;
+
+    search->seen[start] = search->generation;
+    search->cost[start] = 0;
+    search->parent[start] = -1;
+    search->open[0] = start;
+    search->open_index[start] = 0;
+    search->open_size = 1;
+
+    while(search->open_size != 0){
+
+        if(search->open[0] == goal){
+
+            return true;
+        }
+
+        // Pop the cheapest node
+        int current = search->open[0];
+        search->open_size--;
+        if(search->open_size != 0){
+
+            open_swap(search, 0, search->open_size);
+            open_sift_down(graph, search, 0);
+        }
+        search->open_index[current] = -1;
+        search->nodes_expanded++;
+
+        if(current == start){
+
+            for(int edge = 0; edge < search->start_edge_count; edge++){
+
+                graph_relax(graph, search, current, search->start_edges[edge].node, search->start_edges[edge].cost);
+            }
+            continue;
+        }
+
+        for(int edge = 0; edge < graph->nodes[current].edge_count; edge++){
+
+            graph_relax(graph, search, current, graph->nodes[current].edges[edge].node, graph->nodes[current].edges[edge].cost);
+        }
+        if(graph->nodes[current].cluster == search->goal_cluster){
+
+            for(int edge = 0; edge < search->goal_edge_count; edge++){
+
+                if(search->goal_edges[edge].node == current){
+
+                    graph_relax(graph, search, current, goal, search->goal_edges[edge].cost);
+                    break;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+// Turns the node path found by graph_search() into squares
+static void graph_refine_path(hpa_graph* graph, hpa_search* search, path* solution){
+
+    int width = graph->map->width;
+
+    // The open heap isn't needed anymore, so reuse it to hold the nodes in order from the goal back to the start
+    int node_count = 0;
+    for(int node = search->goal_node; node != -1; node = search->parent[node]){
+
+        search->open[node_count] = node;
+        node_count++;
+    }
+
+    solution->length = 0;
+    path_push(solution, (vector){ .x = search->start_square % width, .y = search->start_square / width });
+
+    for(int i = node_count - 1; i > 0; i--){
+
+        int from_square = search_node_square(graph, search, search->open[i]);
+        int to_square = search_node_square(graph, search, search->open[i - 1]);
+        int from_cluster = search_node_cluster(graph, search, search->open[i]);
+        int to_cluster = search_node_cluster(graph, search, search->open[i - 1]);
+        if(from_square == to_square){
+
+            continue;
+        }
+
+        // Edges across a border are always a single step
+        if(from_cluster != to_cluster){
+
+            path_push(solution, (vector){ .x = to_square % width, .y = to_square / width });
+            continue;
+        }
+
+        // Search out from the destination so that following the parents from the source walks the path forwards
+        hpa_cluster* cluster = &graph->clusters[from_cluster];
+        cluster_search(graph, search, cluster, to_square);
+        for(int local = search->local_parent[cluster_local_index(graph, cluster, from_square)]; local != -1; local = search->local_parent[local]){
+
+            path_push(solution, (vector){ .x = cluster->x + (local % cluster->width), .y = cluster->y + (local / cluster->width) });
+        }
+    }
+}
+
+// Graph
+
+hpa_graph* hpa_create(map* the_map){
+
+    hpa_graph* graph = malloc(sizeof(hpa_graph));
+
+    graph->map = the_map;
+    graph->cluster_size = HPA_CLUSTER_SIZE;
+    graph->clusters_wide = (the_map->width + graph->cluster_size - 1) / graph->cluster_size;
+    graph->clusters_high = (the_map->height + graph->cluster_size - 1) / graph->cluster_size;
+
+    // Clusters along the right and bottom edges of the map are cut short if the map isn't a multiple of the cluster size
+    int cluster_count = graph->clusters_wide * graph->clusters_high;
+    graph->clusters = malloc(sizeof(hpa_cluster) * cluster_count);
+    for(int i = 0; i < cluster_count; i++){
+
+        hpa_cluster* cluster = &graph->clusters[i];
+        cluster->x = (i % graph->clusters_wide) * graph->cluster_size;
+        cluster->y = (i / graph->clusters_wide) * graph->cluster_size;
+        cluster->width = the_map->width - cluster->x < graph->cluster_size ? the_map->width - cluster->x : graph->cluster_size;
+        cluster->height = the_map->height - cluster->y < graph->cluster_size ? the_map->height - cluster->y : graph->cluster_size;
+        cluster->nodes = NULL;
+        cluster->node_count = 0;
+        cluster->node_capacity = 0;
+    }
+
+    graph->node_count = 0;
+    graph->node_capacity = 64;
+    graph->nodes = malloc(sizeof(hpa_node) * graph->node_capacity);
+    graph->free_nodes = malloc(sizeof(int) * graph->node_capacity);
+    graph->free_node_count = 0;
+
+    graph->search = hpa_search_create(graph);
+    graph->nodes_expanded = 0;
+
+    for(int i = 0; i < cluster_count; i++){
+
+        if(i % graph->clusters_wide != graph->clusters_wide - 1){
+
+            border_build(graph, i, 0);
+        }
+        if(i / graph->clusters_wide != graph->clusters_high - 1){
+
+            border_build(graph, i, 1);
+        }
+    }
+    for(int i = 0; i < cluster_count; i++){
+
+        cluster_link_nodes(graph, i);
+    }
+
+    return graph;
+}
+
+void hpa_free(hpa_graph* graph){
+
+    for(int i = 0; i < graph->clusters_wide * graph->clusters_high; i++){
+
+        free(graph->clusters[i].nodes);
+    }
+    for(int i = 0; i < graph->node_count; i++){
+
+        free(graph->nodes[i].edges);
+    }
+    free(graph->clusters);
+    free(graph->nodes);
+    free(graph->free_nodes);
+    hpa_search_free(graph->search);
+    free(graph);
+}
+
+void hpa_update_square(hpa_graph* graph, vector square){
+
+    int cluster_index = cluster_at(graph, (int)square.x + ((int)square.y * graph->map->width));
+    hpa_cluster* cluster = &graph->clusters[cluster_index];
+    int cluster_x = cluster_index % graph->clusters_wide;
+    int cluster_y = cluster_index / graph->clusters_wide;
+
+    // The square's own cluster always needs relinking, and so does the cluster on the other side of any border it's on
+    int relink[5] = { cluster_index };
+    int relink_count = 1;
+    if((int)square.x == cluster->x + cluster->width - 1 && cluster_x != graph->clusters_wide - 1){
+
+        border_rebuild(graph, cluster_index, 0);
+        relink[relink_count] = cluster_index + 1;
+        relink_count++;
+    }
+    if((int)square.x == cluster->x && cluster_x != 0){
+
+        border_rebuild(graph, cluster_index - 1, 0);
+        relink[relink_count] = cluster_index - 1;
+        relink_count++;
+    }
+    if((int)square.y == cluster->y + cluster->height - 1 && cluster_y != graph->clusters_high - 1){
+
+        border_rebuild(graph, cluster_index, 1);
+        relink[relink_count] = cluster_index + graph->clusters_wide;
+        relink_count++;
+    }
+    if((int)square.y == cluster->y && cluster_y != 0){
+
+        border_rebuild(graph, cluster_index - graph->clusters_wide, 1);
+        relink[relink_count] = cluster_index - graph->clusters_wide;
+        relink_count++;
+    }
+
+    for(int i = 0; i < relink_count; i++){
+
+        cluster_link_nodes(graph, relink[i]);
+    }
+}
+
+bool hpa_pathfind(hpa_graph* graph, vector start, vector goal, path* solution){
+
+    bool found = hpa_search_pathfind(graph, graph->search, start, goal, solution);
+    graph->nodes_expanded = graph->search->nodes_expanded;
+
+    return found;
+}
+
+// Search
+
+hpa_search* hpa_search_create(hpa_graph* graph){
+
+    hpa_search* search = malloc(sizeof(hpa_search));
+
+    int local_size = graph->cluster_size * graph->cluster_size;
+    search->local_distance = malloc(sizeof(int) * local_size);
+    search->local_parent = malloc(sizeof(int) * local_size);
+    search->local_queue = malloc(sizeof(int) * local_size);
+
+    // Sized to the graph when a search starts, since the graph can grow between searches
+    search->node_capacity = 0;
+    search->generation = 0;
+    search->seen = NULL;
+    search->cost = NULL;
+    search->parent = NULL;
+    search->open_index = NULL;
+    search->open = NULL;
+    search->open_size = 0;
+
+    search->start_node = -1;
+    search->start_square = -1;
+    search->start_cluster = -1;
+    search->start_edges = NULL;
+    search->start_edge_count = 0;
+    search->start_edge_capacity = 0;
+
+    search->goal_node = -1;
+    search->goal_square = -1;
+    search->goal_cluster = -1;
+    search->goal_edges = NULL;
+    search->goal_edge_count = 0;
+    search->goal_edge_capacity = 0;
+
+    search->nodes_expanded = 0;
+
+    return search;
+}
+
+void hpa_search_free(hpa_search* search){
+
+    free(search->local_distance);
+    free(search->local_parent);
+    free(search->local_queue);
+    free(search->seen);
+    free(search->cost);
+    free(search->parent);
+    free(search->open_index);
+    free(search->open);
+    free(search->start_edges);
+    free(search->goal_edges);
+    free(search);
+}
+
+// Makes room for the graph's nodes plus the start and goal
+static void search_reserve(hpa_search* search, int node_count){
+
+    if(node_count <= search->node_capacity){
+
+        return;
+    }
+
+    int old_capacity = search->node_capacity;
+    search->node_capacity = node_count * 2;
+    search->seen = realloc(search->seen, sizeof(int) * search->node_capacity);
+    search->cost = realloc(search->cost, sizeof(int) * search->node_capacity);
+    search->parent = realloc(search->parent, sizeof(int) * search->node_capacity);
+    search->open_index = realloc(search->open_index, sizeof(int) * search->node_capacity);
+    search->open = realloc(search->open, sizeof(int) * search->node_capacity);
+    memset(search->seen + old_capacity, 0, sizeof(int) * (search->node_capacity - old_capacity));
+}
+
+bool hpa_search_pathfind(hpa_graph* graph, hpa_search* search, vector start, vector goal, path* solution){
+
+    map* the_map = graph->map;
+    search->nodes_expanded = 0;
+
+    if(!map_squares_connected(the_map, start, goal)){
+
+        return false;
+    }
+
+    // The start and goal are linked to every node they can reach in their own clusters, but only in the search
+    search_reserve(search, graph->node_count + 2);
+    search->start_node = graph->node_count;
+    search->start_square = (int)start.x + ((int)start.y * the_map->width);
+    search->start_cluster = cluster_at(graph, search->start_square);
+    search->start_edge_count = 0;
+    search->goal_node = graph->node_count + 1;
+    search->goal_square = (int)goal.x + ((int)goal.y * the_map->width);
+    search->goal_cluster = cluster_at(graph, search->goal_square);
+    search->goal_edge_count = 0;
+    hpa_cluster* start_cluster = &graph->clusters[search->start_cluster];
+    hpa_cluster* goal_cluster = &graph->clusters[search->goal_cluster];
+
+    cluster_search(graph, search, start_cluster, search->start_square);
+    for(int i = 0; i < start_cluster->node_count; i++){
+
+        int distance = search->local_distance[cluster_local_index(graph, start_cluster, graph->nodes[start_cluster->nodes[i]].square)];
+        if(distance != -1){
+
+            edge_push(&search->start_edges, &search->start_edge_count, &search->start_edge_capacity, start_cluster->nodes[i], distance);
+        }
+    }
+    if(search->start_cluster == search->goal_cluster){
+
+        int distance = search->local_distance[cluster_local_index(graph, start_cluster, search->goal_square)];
+        if(distance != -1){
+
+            edge_push(&search->start_edges, &search->start_edge_count, &search->start_edge_capacity, search->goal_node, distance);
+        }
+    }
+
+    // Moves go both ways, so the distances out from the goal are also the distances back to it
+    cluster_search(graph, search, goal_cluster, search->goal_square);
+    for(int i = 0; i < goal_cluster->node_count; i++){
+
+        int distance = search->local_distance[cluster_local_index(graph, goal_cluster, graph->nodes[goal_cluster->nodes[i]].square)];
+        if(distance != -1){
+
+            edge_push(&search->goal_edges, &search->goal_edge_count, &search->goal_edge_capacity, goal_cluster->nodes[i], distance);
+        }
+    }
+
+    bool found = graph_search(graph, search);
+    if(found){
+
+        graph_refine_path(graph, search, solution);
+    }
+
+    return found;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "map.h"
+#include "pathfind.h"
+
+#include <stdbool.h>
+
+/*
+ * Hierarchical pathfinding (HPA*)
+ *
+ * The map is split into square clusters. Wherever open squares line up across the border between two clusters there's
+ * an entrance with a node on each side of it, and the nodes inside a cluster are joined by the length of the shortest
+ * path between them that stays in the cluster. A long path can then be found by searching this much smaller graph
+ * and filling in the squares afterwards one cluster at a time
+ *
+ * The paths aren't always the shortest possible, but they're close. When a square's collision changes only the
+ * cluster it's in, and the neighbors it shares a rebuilt border with, have to be recalculated
+ */
+
+typedef struct hpa_edge{
+    int node;
+    int cost;
+} hpa_edge;
+
+typedef struct hpa_node{
+    int square; // -1 if this node isn't in use
+    int cluster;
+    int border; // cluster * 2 for the border on the cluster's right, cluster * 2 + 1 for the border below it
+
+    hpa_edge* edges;
+    int edge_count;
+    int edge_capacity;
+} hpa_node;
+
+typedef struct hpa_cluster{
+    int x;
+    int y;
+    int width;
+    int height;
+
+    int* nodes;
+    int node_count;
+    int node_capacity;
+} hpa_cluster;
+
+// Everything one search of the graph writes to, so that searches with their own can run at the same time on the same
+// graph. The start and goal aren't added to the graph, they're two extra nodes after the graph's own that only the
+// search knows about
+typedef struct hpa_search{
+    // Scratch space for searching inside one cluster
+    int* local_distance;
+    int* local_parent;
+    int* local_queue;
+
+    // Scratch space for searching the graph, sized to node_capacity
+    int node_capacity;
+    int generation;
+    int* seen;
+    int* cost;
+    int* parent;
+    int* open_index;
+    int* open;
+    int open_size;
+
+    int start_node;
+    int start_square;
+    int start_cluster;
+    hpa_edge* start_edges;
+    int start_edge_count;
+    int start_edge_capacity;
+
+    int goal_node;
+    int goal_square;
+    int goal_cluster;
+    hpa_edge* goal_edges; // node is the graph node linked to the goal, and cost how far it is from it
+    int goal_edge_count;
+    int goal_edge_capacity;
+
+    int nodes_expanded; // graph nodes and cluster squares expanded by the last search
+} hpa_search;
+
+typedef struct hpa_graph{
+    map* map;
+    int cluster_size;
+    int clusters_wide;
+    int clusters_high;
+    hpa_cluster* clusters;
+
+    hpa_node* nodes;
+    int node_count;
+    int node_capacity;
+    int* free_nodes;
+    int free_node_count;
+
+    hpa_search* search; // used for building the graph and by hpa_pathfind()
+    int nodes_expanded; // graph nodes and cluster squares expanded by the last call to hpa_pathfind()
+} hpa_graph;
+
+hpa_graph* hpa_create(map* the_map);
+void hpa_free(hpa_graph* graph);
+void hpa_update_square(hpa_graph* graph, vector square); // call when the collision of a square has changed
+bool hpa_pathfind(hpa_graph* graph, vector start, vector goal, path* solution);
+
+hpa_search* hpa_search_create(hpa_graph* graph);
+void hpa_search_free(hpa_search* search);
+bool hpa_search_pathfind(hpa_graph* graph, hpa_search* search, vector start, vector goal, path* solution); // hpa_pathfind() with its own scratch space, it only reads the graph
@@ -0,0 +1,196 @@
+#include "line_of_sight.h"
+#include "vector_array.h"
+
+#include <stdlib.h>
+
+// Cache constants
+const int LINE_OF_SIGHT_CACHE_SIZE = 4096; // must be a power of 2
+
+const int LINE_OF_SIGHT_CHUNK = 32; // rays handed to a thread at a time
+
+static int cache_slot(int origin, int target){
+
+    unsigned int hash = ((unsigned int)origin * 73856093u) ^ ((unsigned int)target * 19349663u);
+    return hash & (LINE_OF_SIGHT_CACHE_SIZE - 1);
+}
+
+static bool is_wall(map* the_map, int x, int y){
+
+    return the_map->wall[x + (y * the_map->width)] != 0;
+}
+
+// Steps through every square the line between the two squares' centres passes through. Where it passes exactly
+// through a corner it's blocked if either square beside the corner is a wall, so sight doesn't slip between diagonal walls
+static bool walk_clear(map* the_map, int origin, int target){
+
+    int x = origin % the_map->width;
+    int y = origin / the_map->width;
+    int target_x = target % the_map->width;
+    int target_y = target / the_map->width;
+
+    int step_x = target_x > x ? 1 : -1;
+    int step_y = target_y > y ? 1 : -1;
+    int distance_x = abs(target_x - x);
+    int distance_y = abs(target_y - y);
+    int error = distance_x - distance_y;
+    distance_x *= 2;
+    distance_y *= 2;
+
+    int squares_left = 1 + ((distance_x + distance_y) / 2);
+    while(squares_left > 0){
+
+        if(is_wall(the_map, x, y)){
+
+            return false;
+        }
+
+        if(error > 0){
+
+            x += step_x;
+            error -= distance_y;
+
+        }else if(error < 0){
+
+            y += step_y;
+            error += distance_x;
+
+        }else{
+
+            if(squares_left > 1 && (is_wall(the_map, x + step_x, y) || is_wall(the_map, x, y + step_y))){
+
+                return false;
+            }
+            x += step_x;
+            y += step_y;
+            error += distance_x - distance_y;
+            squares_left--;
+        }
+        squares_left--;
+    }
+
+    return true;
+}
+
+static void cast_range(void* data, int begin, int end){
+
+    line_of_sight* sight = (line_of_sight*)data;
+    for(int i = begin; i < end; i++){
+
+        sight_query* query = &sight->queries[sight->casts[i]];
+        query->visible = walk_clear(sight->map, query->origin, query->target);
+    }
+}
+
+line_of_sight* line_of_sight_create(map* the_map){
+
+    line_of_sight* sight = malloc(sizeof(line_of_sight));
+    sight->map = the_map;
+
+    sight->query_capacity = 64;
+    sight->query_count = 0;
+    sight->queries = malloc(sizeof(sight_query) * sight->query_capacity);
+
+    sight->cast_capacity = 64;
+    sight->cast_count = 0;
+    sight->casts = malloc(sizeof(int) * sight->cast_capacity);
+
+    sight->cache = malloc(sizeof(sight_cache_entry) * LINE_OF_SIGHT_CACHE_SIZE);
+    for(int i = 0; i < LINE_OF_SIGHT_CACHE_SIZE; i++){
+
+        sight->cache[i].origin = -1;
+        sight->cache[i].query = -1;
+    }
+
+    return sight;
+}
+
+void line_of_sight_free(line_of_sight* sight){
+
+    free(sight->queries);
+    free(sight->casts);
+    free(sight->cache);
+    free(sight);
+}
+
+void line_of_sight_clear(line_of_sight* sight){
+
+    sight->query_count = 0;
+    sight->cast_count = 0;
+}
+
+int line_of_sight_request(line_of_sight* sight, vector origin, vector target, float range){
+
+    map* the_map = sight->map;
+    int origin_square = (int)origin.x + ((int)origin.y * the_map->width);
+    int target_square = (int)target.x + ((int)target.y * the_map->width);
+
+    sight_query query = (sight_query){
+        .origin = origin_square < target_square ? origin_square : target_square,
+        .target = origin_square < target_square ? target_square : origin_square,
+        .copy = -1,
+        .visible = false
+    };
+    vector_array_push((void**)&sight->queries, &query, &sight->query_count, &sight->query_capacity, sizeof(sight_query));
+    int index = sight->query_count - 1;
+    sight_query* current = &sight->queries[index];
+
+    if(current->origin == current->target){
+
+        current->visible = true;
+        return index;
+    }
+    if(vector_distance(origin, target) > range || the_map->wall[current->origin] || the_map->wall[current->target]){
+
+        return index;
+    }
+
+    sight_cache_entry* entry = &sight->cache[cache_slot(current->origin, current->target)];
+    if(entry->origin == current->origin && entry->target == current->target && entry->revision == the_map->collide_revision){
+
+        // Either already answered, or being cast for an earlier query in this batch
+        if(entry->query == -1){
+
+            current->visible = entry->visible;
+
+        }else{
+
+            current->copy = entry->query;
+        }
+        return index;
+    }
+
+    // Claim the cache entry so that later queries for the same pair wait on this one instead of casting again
+    entry->origin = current->origin;
+    entry->target = current->target;
+    entry->revision = the_map->collide_revision;
+    entry->query = index;
+    vector_array_push((void**)&sight->casts, &index, &sight->cast_count, &sight->cast_capacity, sizeof(int));
+
+    return index;
+}
+
+void line_of_sight_resolve(line_of_sight* sight, worker_pool* workers){
+
+    worker_pool_run(workers, cast_range, sight, sight->cast_count, LINE_OF_SIGHT_CHUNK);
+
+    // Answer the cache entries the casts claimed, unless a later pair has taken the entry since
+    for(int i = 0; i < sight->cast_count; i++){
+
+        sight_query* query = &sight->queries[sight->casts[i]];
+        sight_cache_entry* entry = &sight->cache[cache_slot(query->origin, query->target)];
+        if(entry->query == sight->casts[i]){
+
+            entry->visible = query->visible;
+            entry->query = -1;
+        }
+    }
+
+    // Copies always point back at an earlier query, so going in order every copy's answer is already there
+    for(int i = 0; i < sight->query_count; i++){
+
+        if(sight->queries[i].copy != -1){
+
+            sight->queries[i].visible = sight->queries[sight->queries[i].copy].visible;
+        }
+    }
+}
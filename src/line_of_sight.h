@@ -0,0 +1,55 @@
+#pragma once
+
+#include "vector.h"
+#include "map.h"
+#include "worker_pool.h"
+
+#include <stdbool.h>
+
+/*
+ * Answers whether pairs of squares can see each other, a whole batch of pairs at a time
+ *
+ * Pairs are queued with line_of_sight_request() during a tick and all answered by line_of_sight_resolve(). Sight runs
+ * from the centre of one square to the centre of the other and is blocked by walls, so an answer holds for every two
+ * points in the same two squares and is cached per pair of squares until the map's collide_revision changes
+ *
+ * The cheap checks are tried before any ray: the same square, out of range, a wall at either end and then the cache.
+ * Whatever is left is walked over the squares in integer steps, split across the worker pool, and the answers are
+ * put in the cache afterwards so the walks don't write anything they share
+ */
+
+typedef struct sight_query{
+    int origin; // square index, the lower of the pair so that both directions share a cache entry
+    int target;
+    int copy; // earlier query in the batch for the same pair whose answer this one takes, or -1
+    bool visible;
+} sight_query;
+
+typedef struct sight_cache_entry{
+    int origin; // -1 if the entry is empty
+    int target;
+    int revision; // the map's collide_revision when this was cast
+    int query; // the query in the current batch that's casting this pair, or -1 if it's already answered
+    bool visible;
+} sight_cache_entry;
+
+typedef struct line_of_sight{
+    map* map;
+
+    sight_query* queries;
+    int query_count;
+    int query_capacity;
+
+    int* casts; // queries that need a ray walked
+    int cast_count;
+    int cast_capacity;
+
+    sight_cache_entry* cache; // direct mapped, a pair just replaces whatever was in its entry
+} line_of_sight;
+
+line_of_sight* line_of_sight_create(map* the_map);
+void line_of_sight_free(line_of_sight* sight);
+
+void line_of_sight_clear(line_of_sight* sight); // forgets the last batch so a new one can be queued
+int line_of_sight_request(line_of_sight* sight, vector origin, vector target, float range); // returns the query, its answer is in queries[query].visible once resolved. Pairs further apart than range can't see each other
+void line_of_sight_resolve(line_of_sight* sight, worker_pool* workers);
@@ -15,6 +15,10 @@ int main(){
     }
 
     State* state = state_init();
+    if(!engine_prefetch_state(state)){
+
+        return 0;
+    }
     bool input_held[4] = {false, false, false, false};
 
     bool running = true;
@@ -35,6 +39,10 @@ int main(){
 
                     engine_toggle_fullscreen();
 
+                }else if(key == SDLK_F2){
+
+                    engine_toggle_indexed_color();
+
                 }if(key == SDLK_w){
 
                     state->player_move_dir.y = -1;
@@ -108,6 +116,12 @@ int main(){
         engine_render_state(state);
     }
 
+    path_queue_free(state->path_queue);
+    line_of_sight_free(state->sight);
+    worker_pool_free(state->workers);
+    timer_wheel_free(state->timers);
+    projectile_list_free(&state->projectiles);
+    particle_list_free(&state->particles);
     free(state);
 
     engine_quit();
@@ -1,6 +1,7 @@
 #include "map.h"
 
-#include "vector_array.h"
+#include "pathfind.h"
+#include "hpa.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -117,6 +118,12 @@ map* map_load_from_tmx(const char* path){
                 new_map->objects = malloc(sizeof(int) * map_size);
                 new_map->entities = malloc(sizeof(int) * map_size);
                 new_map->collidemap = malloc(sizeof(bool) * map_size);
+                new_map->collide_revision = 0;
+                new_map->components = NULL;
+                new_map->fill_queue = NULL;
+                new_map->jump_distances = NULL;
+                new_map->search = NULL;
+                new_map->hierarchy = NULL;
 
             }else if(starts_with(line_buffer, "<tileset")){
 
@@ -203,10 +210,70 @@ map* map_load_from_tmx(const char* path){
     fclose(file);
 
     map_generate_collidemap(new_map);
+    new_map->hierarchy = hpa_create(new_map);
 
     return new_map;
 }
 
+void map_free(map* the_map){
+
+    free(the_map->wall);
+    free(the_map->ceil);
+    free(the_map->floor);
+    free(the_map->objects);
+    free(the_map->entities);
+    free(the_map->collidemap);
+    free(the_map->components);
+    free(the_map->fill_queue);
+    free(the_map->jump_distances);
+    if(the_map->search != NULL){
+
+        pathfind_search_free(the_map->search);
+    }
+    if(the_map->hierarchy != NULL){
+
+        hpa_free(the_map->hierarchy);
+    }
+    free(the_map);
+}
+
+// Gives every open square that can be reached from square the label component
+// queue needs room for every square on the map
+void map_fill_component(map* the_map, int square, int component, int* queue){
+
+    static const int direction_x[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+    static const int direction_y[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+    the_map->components[square] = component;
+    queue[0] = square;
+    int queue_head = 0;
+    int queue_tail = 1;
+
+    while(queue_head != queue_tail){
+
+        int current = queue[queue_head];
+        queue_head++;
+
+        int current_x = current % the_map->width;
+        int current_y = current / the_map->width;
+        for(int direction = 0; direction < 8; direction++){
+
+            if(!pathfind_move_allowed(the_map, current_x, current_y, direction_x[direction], direction_y[direction])){
+
+                continue;
+            }
+
+            int child = current_x + direction_x[direction] + ((current_y + direction_y[direction]) * the_map->width);
+            if(the_map->components[child] != component){
+
+                the_map->components[child] = component;
+                queue[queue_tail] = child;
+                queue_tail++;
+            }
+        }
+    }
+}
+
 void map_generate_collidemap(map* the_map){
 
     int map_size = the_map->width * the_map->height;
@@ -215,176 +282,149 @@ void map_generate_collidemap(map* the_map){
 
         the_map->collidemap[i] = the_map->wall[i] != 0 || the_map->objects[i] != 0;
     }
-}
 
-bool map_square_occupied(map* the_map, vector square){
+    // Label the connected areas so that impossible paths can be ruled out without searching
+    if(the_map->components == NULL){
 
-    // First check if in bounds
-    if(square.x < 0 || square.x >= the_map->width || square.y < 0 || square.y >= the_map->height){
+        the_map->components = malloc(sizeof(int) * map_size);
+    }
+    for(int i = 0; i < map_size; i++){
 
-        return true;
+        the_map->components[i] = -1;
     }
 
-    // Then cast to int and check the static collidemap
-    // This function doesn't check living entities, it's really used more for pathfinding around walls and objects
-    return the_map->collidemap[(int)square.x + ((int)square.y * the_map->width)];
-}
+    if(the_map->fill_queue == NULL){
 
-bool map_pathfind(map* the_map, vector start, vector goal, vector* solution){
-
-    typedef struct{
-        vector position;
-        int direction;
-        int path_length;
-        int score;
-    } node;
-
-    static const vector direction_vectors[8] = {
-        (vector){ .x = 0, .y = -1 }, // up
-        (vector){ .x = 1, .y = -1 }, // up right
-        (vector){ .x = 1, .y = 0 }, // right
-        (vector){ .x = 1, .y = 1 }, // down right
-        (vector){ .x = 0, .y = 1 }, // down
-        (vector){ .x = -1, .y = 1 }, // down left
-        (vector){ .x = -1, .y = 0 }, // left
-        (vector){ .x = -1, .y = -1 } // up left
-    };
-
-    vector goal_square = (vector){ .x = (int)goal.x, .y = (int)goal.y };
-    vector start_square = (vector){ .x = (int)start.x, .y = (int)start.y };
-
-    int frontier_size = 0;
-    int frontier_capacity = 16;
-    node* frontier = malloc(sizeof(node) * frontier_capacity);
-    int explored_size = 0;
-    int explored_capacity = 16;
-    node* explored = malloc(sizeof(node) * explored_capacity);
-
-    node start_node = (node){
-        .position = start_square,
-        .direction = -1,
-        .path_length = 0,
-        .score = abs((int)(goal_square.x - start_square.x)) + abs((int)(goal_square.y - start_square.y))
-    };
-    vector_array_push((void**)&frontier, &start_node, &frontier_size, &frontier_capacity, sizeof(node));
-
-    while(true){
-
-        if(frontier_size == 0){
-
-            printf("Pathfinding failed!\n");
-            bool goal_blocked = the_map->collidemap[(int)goal_square.x + ((int)goal_square.y * the_map->width)];
-            bool start_blocked = the_map->collidemap[(int)start_square.x + ((int)start_square.y * the_map->width)];
-            printf("goal is blocked? %i start is blocked? %i\n", (int)goal_blocked, (int)start_blocked);
-            return false;
-        }
-
-        // Find the smallest cost node
-        int smallest_index = 0;
-        for(int i = 1; i < frontier_size; i++){
+        the_map->fill_queue = malloc(sizeof(int) * map_size);
+    }
+    the_map->component_count = 0;
+    for(int i = 0; i < map_size; i++){
 
-            if(frontier[i].score < frontier[smallest_index].score){
+        if(!the_map->collidemap[i] && the_map->components[i] == -1){
 
-                smallest_index = i;
-            }
+            map_fill_component(the_map, i, the_map->component_count, the_map->fill_queue);
+            the_map->component_count++;
         }
+    }
 
-        // Remove it from the frontier
-        node smallest = frontier[smallest_index];
-        vector_array_delete(frontier, smallest_index, &frontier_size, sizeof(node));
+    pathfind_build_jumps(the_map);
+}
 
-        // Check if it's the solution
-        if(smallest.position.x == goal_square.x && smallest.position.y == goal_square.y){
+void map_update_collidemap(map* the_map, vector square){
 
-            (*solution) = vector_sum(start_square, direction_vectors[smallest.direction]);
-            return true;
-        }
+    int index = (int)square.x + ((int)square.y * the_map->width);
+    bool occupied = the_map->wall[index] != 0 || the_map->objects[index] != 0;
+    if(the_map->collidemap[index] == occupied){
 
-        // Add it to explored
-        vector_array_push((void**)&explored, &smallest, &explored_size, &explored_capacity, sizeof(node));
+        return;
+    }
 
-        // Expand out all possible paths based on the one we've chosen
-        for(int direction = 0; direction < 8; direction++){
+    the_map->collidemap[index] = occupied;
+    the_map->collide_revision++;
+    pathfind_update_jumps(the_map, square);
+    if(the_map->hierarchy != NULL){
 
-            vector child_pos = vector_sum(smallest.position, direction_vectors[direction]);
+        hpa_update_square(the_map->hierarchy, square);
+    }
 
-            // If the path leads to an invalid square, ignore it
-            if(map_square_occupied(the_map, child_pos)){
+    // Only the areas touching the square can have changed, so relabel those rather than the whole map
+    // Labels are never reused so that a relabeled area can't be mistaken for one that hasn't been reached yet
+    int* queue = the_map->fill_queue;
+    if(occupied){
 
-                continue;
-            }
+        // Blocking a square can split its area up, and every piece has to touch the square
+        int old_component = the_map->components[index];
+        the_map->components[index] = -1;
+        for(int y = (int)square.y - 1; y <= (int)square.y + 1; y++){
 
-            // If moving diagonally, make sure this movement isn't taking us through a wall corner
-            bool direction_is_diagonal = direction % 2 == 1;
-            if(direction_is_diagonal){
+            for(int x = (int)square.x - 1; x <= (int)square.x + 1; x++){
 
-                vector child_pos_x_component = vector_sum(smallest.position, (vector){ .x = direction_vectors[direction].x, .y = 0 });
-                vector child_pos_y_component = vector_sum(smallest.position, (vector){ .x = 0, .y = direction_vectors[direction].y });
-                if(map_square_occupied(the_map, child_pos_x_component) || map_square_occupied(the_map, child_pos_y_component)){
+                if(x < 0 || x >= the_map->width || y < 0 || y >= the_map->height){
 
                     continue;
                 }
-            }
 
-            // Create the child node
-            int first_direction = smallest.direction;
-            if(first_direction == -1){
+                int neighbor = x + (y * the_map->width);
+                if(the_map->components[neighbor] == old_component && old_component != -1){
 
-                first_direction = direction;
-            }
-            int path_length = smallest.path_length + 1;
-            int score = path_length + abs((int)(goal_square.x - child_pos.x)) + abs((int)(goal_square.y - child_pos.y));
-            node child = (node){
-                .position = child_pos,
-                .direction = first_direction,
-                .path_length = path_length,
-                .score = score
-            };
-
-            // Ignore this child if in explored
-            bool child_in_explored = false;
-            for(int i = 0; i < explored_size; i++){
-
-                if(child.position.x == explored[i].position.x && child.position.y == explored[i].position.y){
-
-                    child_in_explored = true;
-                    break;
+                    map_fill_component(the_map, neighbor, the_map->component_count, queue);
+                    the_map->component_count++;
                 }
             }
-            if(child_in_explored){
+        }
 
-                continue;
-            }
+    }else{
 
-            // Ignore this child if in frontier
-            bool child_in_frontier = false;
-            int frontier_index = -1;
-            for(int i = 0; i < frontier_size; i++){
+        // Opening a square joins every area around it into one
+        map_fill_component(the_map, index, the_map->component_count, queue);
+        the_map->component_count++;
+    }
+}
 
-                if(child.position.x == frontier[i].position.x && child.position.y == frontier[i].position.y){
+bool map_squares_connected(map* the_map, vector start, vector goal){
 
-                    child_in_frontier = true;
-                    frontier_index = i;
-                    break;
-                }
-            }
+    if((int)start.x == (int)goal.x && (int)start.y == (int)goal.y){
+
+        return true;
+    }
 
-            if(child_in_frontier){
+    int goal_component = the_map->components[(int)goal.x + ((int)goal.y * the_map->width)];
+    if(goal_component == -1){
 
-                // If child is in frontier but with a smaller cost, replace the frontier version with the child
-                if(child.score < frontier[frontier_index].score){
+        return false;
+    }
 
-                    frontier[frontier_index] = child;
-                }
-                continue;
+    int start_component = the_map->components[(int)start.x + ((int)start.y * the_map->width)];
+    if(start_component != -1){
+
+        return start_component == goal_component;
+    }
+
+    // Something standing in an occupied square can still step out of it, so check every way it could go
+    for(int direction_y = -1; direction_y <= 1; direction_y++){
+
+        for(int direction_x = -1; direction_x <= 1; direction_x++){
+
+            if(pathfind_move_allowed(the_map, (int)start.x, (int)start.y, direction_x, direction_y) && the_map->components[(int)start.x + direction_x + (((int)start.y + direction_y) * the_map->width)] == goal_component){
+
+                return true;
             }
+        }
+    }
 
-            // Finally, if child is neither in frontier nor explored, add it to the frontier
-            vector_array_push((void**)&frontier, &child, &frontier_size, &frontier_capacity, sizeof(node));
-        } // End for each direction
+    return false;
+}
+
+bool map_square_occupied(map* the_map, vector square){
+
+    // First check if in bounds
+    if(square.x < 0 || square.x >= the_map->width || square.y < 0 || square.y >= the_map->height){
 
-    } // End while true
+        return true;
+    }
+
+    // Then cast to int and check the static collidemap
+    // This function doesn't check living entities, it's really used more for pathfinding around walls and objects
+    return the_map->collidemap[(int)square.x + ((int)square.y * the_map->width)];
+}
+
+bool map_pathfind(map* the_map, vector start, vector goal, path* solution){
+
+    if(pathfind_active_mode == PATHFIND_MODE_HPA){
+
+        return hpa_pathfind(the_map->hierarchy, start, goal, solution);
+    }
+
+    if(the_map->search == NULL){
+
+        the_map->search = pathfind_search_create(the_map);
+    }
+
+    pathfind_search_begin(the_map->search, start, goal);
+    if(pathfind_search_run(the_map->search, 0) == PATHFIND_FAILED){
+
+        return false;
+    }
 
-    free(frontier);
-    free(explored);
+    return pathfind_search_get_path(the_map->search, solution);
 }
@@ -2,6 +2,11 @@
 
 #include "vector.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+struct path;
+struct pathfind_search;
+struct hpa_graph;
 
 typedef struct map{
 
@@ -11,11 +16,22 @@ typedef struct map{
     int* objects;
     int* entities;
     bool* collidemap;
+    int collide_revision; // incremented every time a square of the collidemap changes, so that cached paths know to check themselves
+    int* components; // which connected area each open square is in, -1 for occupied squares
+    int component_count;
+    int* fill_queue; // scratch for relabeling components, room for every square so tile changes don't have to allocate
+    int16_t* jump_distances; // 4 per square for jump point search, see pathfind_build_jumps()
     int width;
     int height;
+
+    struct pathfind_search* search; // reused by map_pathfind() so it doesn't allocate on every call
+    struct hpa_graph* hierarchy; // cluster graph for PATHFIND_MODE_HPA, built from the collidemap when the map is loaded
 } map;
 
 map* map_load_from_tmx(const char* path);
+void map_free(map* the_map);
 void map_generate_collidemap(map* the_map);
+void map_update_collidemap(map* the_map, vector square); // call after changing the wall or objects at a square, through path_queue_update_square() if a path queue is searching the map
 bool map_square_occupied(map* the_map, vector square);
-bool map_pathfind(map* the_map, vector start, vector goal, vector* solution);
+bool map_squares_connected(map* the_map, vector start, vector goal); // returns false if there can't be a path between the squares, in constant time
+bool map_pathfind(map* the_map, vector start, vector goal, struct path* solution); // fills solution with every square from start to goal
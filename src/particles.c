@@ -0,0 +1,144 @@
+#include "particles.h"
+
+#include <math.h>
+
+// Particle movement constants
+const float PARTICLE_GRAVITY = 0.001; // taken off every particle's rise each tick
+const float PARTICLE_FLOOR = -0.5;
+const float PARTICLE_CEILING = 0.5;
+
+const float PARTICLE_SIZES[NUM_PARTICLE_KINDS] = { 0.03, 0.02, 0.04 };
+
+void projectile_list_init(projectile_list* projectiles, int capacity){
+
+    entity_store* store = &projectiles->store;
+    entity_store_init(store, capacity);
+    entity_store_add_column(store, (void**)&projectiles->image, sizeof(int));
+    entity_store_add_column(store, (void**)&projectiles->position, sizeof(vector));
+    entity_store_add_column(store, (void**)&projectiles->velocity, sizeof(vector));
+}
+
+void projectile_list_free(projectile_list* projectiles){
+
+    entity_store_free(&projectiles->store);
+}
+
+int projectile_list_add(projectile_list* projectiles, int image, vector position, vector velocity){
+
+    int index = entity_store_push(&projectiles->store);
+    if(index == -1){
+
+        return -1;
+    }
+
+    projectiles->image[index] = image;
+    projectiles->position[index] = position;
+    projectiles->velocity[index] = velocity;
+
+    return index;
+}
+
+void particle_list_init(particle_list* particles, int capacity){
+
+    entity_store* store = &particles->store;
+    entity_store_init(store, capacity);
+    entity_store_add_column(store, (void**)&particles->kind, sizeof(particle_kind));
+    entity_store_add_column(store, (void**)&particles->position, sizeof(vector));
+    entity_store_add_column(store, (void**)&particles->velocity, sizeof(vector));
+    entity_store_add_column(store, (void**)&particles->height, sizeof(float));
+    entity_store_add_column(store, (void**)&particles->rise, sizeof(float));
+    entity_store_add_column(store, (void**)&particles->life, sizeof(float));
+    entity_store_add_column(store, (void**)&particles->size, sizeof(float));
+
+    particles->seed = 1;
+}
+
+void particle_list_free(particle_list* particles){
+
+    entity_store_free(&particles->store);
+}
+
+int particle_spawn(particle_list* particles, particle_kind kind, vector position, float height, vector velocity, float rise, float life){
+
+    int index = entity_store_push(&particles->store);
+    if(index == -1){
+
+        return -1;
+    }
+
+    particles->kind[index] = kind;
+    particles->position[index] = position;
+    particles->velocity[index] = velocity;
+    particles->height[index] = height;
+    particles->rise[index] = rise;
+    particles->life[index] = life;
+    particles->size[index] = PARTICLE_SIZES[kind];
+
+    return index;
+}
+
+// Returns a number from -1 to 1
+static float particle_random(particle_list* particles){
+
+    particles->seed = (particles->seed * 1103515245u) + 12345u;
+    return (((particles->seed >> 16) & 0x7fff) / 16383.5f) - 1;
+}
+
+void particle_burst(particle_list* particles, particle_kind kind, vector position, float height, vector velocity, float spread, int count, float life){
+
+    for(int i = 0; i < count; i++){
+
+        float angle = particle_random(particles) * PI;
+        float speed = particle_random(particles) * spread;
+        vector scatter = (vector){ .x = cos(angle) * speed, .y = sin(angle) * speed };
+        float rise = particle_random(particles) * spread;
+
+        // Spread the lifetimes out a little so a burst doesn't all vanish on the same tick
+        float particle_life = life * (1 + (0.25 * particle_random(particles)));
+        if(particle_spawn(particles, kind, position, height, vector_sum(velocity, scatter), rise, particle_life) == -1){
+
+            return;
+        }
+    }
+}
+
+static void particle_integrate_heights(float* restrict heights, float* restrict rises, float* restrict lives, int count){
+
+    for(int i = 0; i < count; i++){
+
+        heights[i] += rises[i];
+        rises[i] -= PARTICLE_GRAVITY;
+        lives[i] -= 1;
+    }
+}
+
+void particle_list_update(particle_list* particles, map* the_map){
+
+    int count = particles->store.count;
+    entity_integrate(particles->position, particles->velocity, count);
+    particle_integrate_heights(particles->height, particles->rise, particles->life, count);
+
+    // Nothing holds on to a particle, so finished ones are removed right away rather than queued. Going from the back,
+    // whichever particle is moved into a removed one's place has already been checked
+    for(int i = count - 1; i >= 0; i--){
+
+        vector position = particles->position[i];
+        bool finished = particles->life[i] <= 0 || particles->height[i] <= PARTICLE_FLOOR || particles->height[i] >= PARTICLE_CEILING;
+        if(!finished){
+
+            if(position.x < 0 || position.y < 0 || position.x >= the_map->width || position.y >= the_map->height){
+
+                finished = true;
+
+            }else{
+
+                finished = the_map->wall[(int)position.x + ((int)position.y * the_map->width)] != 0;
+            }
+        }
+
+        if(finished){
+
+            entity_store_swap_remove(&particles->store, i);
+        }
+    }
+}
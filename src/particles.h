@@ -0,0 +1,56 @@
+#pragma once
+
+#include "vector.h"
+#include "map.h"
+#include "entity_store.h"
+
+#include <stdbool.h>
+
+/*
+ * Projectiles and particles, stored the same way as enemies with each field in its own array
+ *
+ * Particles are small points of colour thrown off by spells. There can be thousands of them, so nothing else ever
+ * refers to one and they're updated all at once: every position is moved in one loop, then every particle is checked
+ * against the map grid in another, and the ones that ran out of life or hit a wall, the floor or the ceiling are
+ * removed straight away. Height is how far above eye level a particle is, the floor is at -0.5 and the ceiling at 0.5
+ */
+
+typedef struct projectile_list{
+    entity_store store;
+
+    int* image;
+    vector* position;
+    vector* velocity;
+} projectile_list;
+
+// What a particle looks like, the renderer decides the actual colour of each kind
+typedef enum particle_kind{
+    PARTICLE_BOLT_TRAIL,
+    PARTICLE_BOLT_SPARK,
+    PARTICLE_KINETIC,
+    NUM_PARTICLE_KINDS
+} particle_kind;
+
+typedef struct particle_list{
+    entity_store store;
+
+    particle_kind* kind;
+    vector* position;
+    vector* velocity;
+    float* height;
+    float* rise; // how much the height changes each tick
+    float* life; // ticks left until it's removed
+    float* size; // width in world units
+
+    unsigned int seed; // for scattering bursts, so the same spawns always scatter the same way
+} particle_list;
+
+void projectile_list_init(projectile_list* projectiles, int capacity);
+void projectile_list_free(projectile_list* projectiles);
+int projectile_list_add(projectile_list* projectiles, int image, vector position, vector velocity); // returns the new projectile's index, or -1 if the list is full
+
+void particle_list_init(particle_list* particles, int capacity);
+void particle_list_free(particle_list* particles);
+int particle_spawn(particle_list* particles, particle_kind kind, vector position, float height, vector velocity, float rise, float life); // returns the new particle's index, or -1 if the list is full
+void particle_burst(particle_list* particles, particle_kind kind, vector position, float height, vector velocity, float spread, int count, float life); // spawns count particles moving at velocity plus up to spread in a random direction, for as many as there's room for
+void particle_list_update(particle_list* particles, map* the_map); // moves every particle and removes the ones that are finished
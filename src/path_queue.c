@@ -0,0 +1,340 @@
+#include "path_queue.h"
+#include "hpa.h"
+
+#include <stdlib.h>
+
+const int PATH_QUEUE_SEARCHES = 8;
+
+// Jobs
+
+static path_job* job_create(path_queue* queue){
+
+    path_job* job = queue->free_jobs;
+    if(job != NULL){
+
+        queue->free_jobs = job->next;
+        return job;
+    }
+
+    job = malloc(sizeof(path_job));
+    job->result = (path){ .squares = NULL, .length = 0, .capacity = 0 };
+
+    return job;
+}
+
+// Jobs go back on the free list with their path memory, so requesting doesn't have to allocate once things warm up
+static void job_destroy(path_queue* queue, path_job* job){
+
+    job->next = queue->free_jobs;
+    queue->free_jobs = job;
+}
+
+static void job_release(path_queue* queue, path_job* job){
+
+    job->references--;
+
+    // Jobs still in the pending list get dropped by the worker when it reaches them
+    if(job->references == 0 && job->status != PATHFIND_SEARCHING){
+
+        job_destroy(queue, job);
+    }
+}
+
+// Worker
+
+// Resumes a kept search with the same start if there is one, otherwise starts over in the least recently used one
+static pathfind_search* worker_start_search(path_queue* queue, path_job* job){
+
+    int width = queue->map->width;
+    vector start = (vector){ .x = job->start % width, .y = job->start / width };
+    vector goal = (vector){ .x = job->goal % width, .y = job->goal / width };
+
+    queue->search_clock++;
+    int oldest = 0;
+    for(int i = 0; i < queue->search_count; i++){
+
+        pathfind_search* search = queue->searches[i];
+        if(search != NULL && search->start == job->start && search->mode == job->mode && pathfind_search_retarget(search, goal)){
+
+            queue->search_last_used[i] = queue->search_clock;
+            return search;
+        }
+        if(queue->search_last_used[i] < queue->search_last_used[oldest]){
+
+            oldest = i;
+        }
+    }
+
+    if(queue->searches[oldest] == NULL){
+
+        queue->searches[oldest] = pathfind_search_create(queue->map);
+    }
+    queue->search_last_used[oldest] = queue->search_clock;
+    pathfind_search_begin_mode(queue->searches[oldest], start, goal, job->mode);
+
+    return queue->searches[oldest];
+}
+
+// Works on the first pending job outside of the queue's lock but inside its map_lock, returns the number of squares it expanded
+// Hierarchical searches can't be paused, so they always run to the end and are charged for everything they expanded,
+// even past the budget
+static int worker_run_job(path_queue* queue, path_job* job, int budget, pathfind_status* status){
+
+    int width = queue->map->width;
+
+    if(job->mode == PATHFIND_MODE_HPA){
+
+        if(queue->hpa_search == NULL){
+
+            queue->hpa_search = hpa_search_create(queue->map->hierarchy);
+        }
+        vector start = (vector){ .x = job->start % width, .y = job->start / width };
+        vector goal = (vector){ .x = job->goal % width, .y = job->goal / width };
+        bool found = hpa_search_pathfind(queue->map->hierarchy, queue->hpa_search, start, goal, &job->result);
+        *status = found ? PATHFIND_FOUND : PATHFIND_FAILED;
+
+        return queue->hpa_search->nodes_expanded;
+    }
+
+    if(job->search == NULL){
+
+        job->search = worker_start_search(queue, job);
+    }
+
+    int expanded_before = job->search->nodes_expanded;
+    *status = pathfind_search_run(job->search, budget);
+    if(*status == PATHFIND_FOUND){
+
+        pathfind_search_get_path(job->search, &job->result);
+    }
+
+    return job->search->nodes_expanded - expanded_before;
+}
+
+static void* worker_main(void* data){
+
+    path_queue* queue = (path_queue*)data;
+
+    pthread_mutex_lock(&queue->lock);
+    while(queue->running){
+
+        path_job* job = queue->pending;
+
+        // Nobody's waiting on this job anymore, so don't bother with it
+        if(job != NULL && job->references == 0){
+
+            queue->pending = job->next;
+            if(queue->pending == NULL){
+
+                queue->pending_last = NULL;
+            }
+            job_destroy(queue, job);
+            continue;
+        }
+
+        if(job == NULL || queue->expansions_left <= 0){
+
+            pthread_cond_wait(&queue->wake, &queue->lock);
+            continue;
+        }
+
+        // The status only gets published under the lock, so the requester can't see a half written path
+        int budget = queue->expansions_left;
+        pathfind_status status;
+        pthread_mutex_unlock(&queue->lock);
+        pthread_mutex_lock(&queue->map_lock);
+        int expanded = worker_run_job(queue, job, budget, &status);
+        pthread_mutex_unlock(&queue->map_lock);
+        pthread_mutex_lock(&queue->lock);
+
+        queue->expansions_left -= expanded;
+        if(status != PATHFIND_SEARCHING){
+
+            job->status = status;
+            job->search = NULL;
+            queue->pending = job->next;
+            if(queue->pending == NULL){
+
+                queue->pending_last = NULL;
+            }
+            if(job->references == 0){
+
+                job_destroy(queue, job);
+            }
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return NULL;
+}
+
+// Queue
+
+path_queue* path_queue_create(map* the_map, int expansion_budget){
+
+    path_queue* queue = malloc(sizeof(path_queue));
+
+    queue->map = the_map;
+    queue->running = true;
+    queue->expansion_budget = expansion_budget;
+    queue->expansions_left = expansion_budget;
+    queue->pending = NULL;
+    queue->pending_last = NULL;
+    queue->free_jobs = NULL;
+
+    queue->search_count = PATH_QUEUE_SEARCHES;
+    queue->searches = malloc(sizeof(pathfind_search*) * queue->search_count);
+    queue->search_last_used = malloc(sizeof(int) * queue->search_count);
+    for(int i = 0; i < queue->search_count; i++){
+
+        queue->searches[i] = NULL;
+        queue->search_last_used[i] = 0;
+    }
+    queue->search_clock = 0;
+    queue->hpa_search = NULL;
+
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->wake, NULL);
+    pthread_mutex_init(&queue->map_lock, NULL);
+    pthread_create(&queue->thread, NULL, worker_main, queue);
+
+    return queue;
+}
+
+void path_queue_free(path_queue* queue){
+
+    pthread_mutex_lock(&queue->lock);
+    queue->running = false;
+    pthread_cond_signal(&queue->wake);
+    pthread_mutex_unlock(&queue->lock);
+    pthread_join(queue->thread, NULL);
+
+    pthread_mutex_destroy(&queue->lock);
+    pthread_cond_destroy(&queue->wake);
+    pthread_mutex_destroy(&queue->map_lock);
+
+    // Anything still pending is dropped along with the queue
+    while(queue->pending != NULL){
+
+        path_job* job = queue->pending;
+        queue->pending = job->next;
+        job_destroy(queue, job);
+    }
+    while(queue->free_jobs != NULL){
+
+        path_job* job = queue->free_jobs;
+        queue->free_jobs = job->next;
+        path_free(&job->result);
+        free(job);
+    }
+
+    for(int i = 0; i < queue->search_count; i++){
+
+        if(queue->searches[i] != NULL){
+
+            pathfind_search_free(queue->searches[i]);
+        }
+    }
+    if(queue->hpa_search != NULL){
+
+        hpa_search_free(queue->hpa_search);
+    }
+    free(queue->searches);
+    free(queue->search_last_used);
+    free(queue);
+}
+
+void path_queue_tick(path_queue* queue){
+
+    pthread_mutex_lock(&queue->lock);
+    // Budget that went unused isn't saved up, but going over it is paid back out of the next ticks
+    if(queue->expansions_left > 0){
+
+        queue->expansions_left = queue->expansion_budget;
+
+    }else{
+
+        queue->expansions_left += queue->expansion_budget;
+    }
+    pthread_cond_signal(&queue->wake);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+path_job* path_queue_request(path_queue* queue, vector start, vector goal){
+
+    int width = queue->map->width;
+    int start_square = (int)start.x + ((int)start.y * width);
+    int goal_square = (int)goal.x + ((int)goal.y * width);
+
+    pthread_mutex_lock(&queue->lock);
+
+    // Merge with a pending job going the same way if there is one
+    for(path_job* job = queue->pending; job != NULL; job = job->next){
+
+        if(job->start == start_square && job->goal == goal_square && job->revision == queue->map->collide_revision && job->mode == pathfind_active_mode && job->references != 0){
+
+            job->references++;
+            pthread_mutex_unlock(&queue->lock);
+            return job;
+        }
+    }
+
+    path_job* job = job_create(queue);
+    job->start = start_square;
+    job->goal = goal_square;
+    job->revision = queue->map->collide_revision;
+    job->mode = pathfind_active_mode;
+    job->status = PATHFIND_SEARCHING;
+    job->result.length = 0;
+    job->references = 1;
+    job->search = NULL;
+    job->next = NULL;
+    if(queue->pending_last == NULL){
+
+        queue->pending = job;
+
+    }else{
+
+        queue->pending_last->next = job;
+    }
+    queue->pending_last = job;
+
+    pthread_cond_signal(&queue->wake);
+    pthread_mutex_unlock(&queue->lock);
+
+    return job;
+}
+
+pathfind_status path_queue_collect(path_queue* queue, path_job* job, path* solution, int* revision){
+
+    pthread_mutex_lock(&queue->lock);
+
+    pathfind_status status = job->status;
+    if(status != PATHFIND_SEARCHING){
+
+        if(status == PATHFIND_FOUND){
+
+            path_copy(solution, &job->result);
+        }
+        *revision = job->revision;
+        job_release(queue, job);
+    }
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return status;
+}
+
+void path_queue_cancel(path_queue* queue, path_job* job){
+
+    pthread_mutex_lock(&queue->lock);
+    job_release(queue, job);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+void path_queue_update_square(path_queue* queue, vector square){
+
+    pthread_mutex_lock(&queue->map_lock);
+    map_update_collidemap(queue->map, square);
+    pthread_mutex_unlock(&queue->map_lock);
+}
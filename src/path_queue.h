@@ -0,0 +1,72 @@
+#pragma once
+
+#include "map.h"
+#include "pathfind.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/*
+ * Runs path requests on a worker thread so that a slow search never holds up a tick
+ *
+ * The worker only expands as many squares per tick as the queue's expansion_budget allows, picking up where it
+ * left off once path_queue_tick() hands it the next tick's budget. Hierarchical searches can't be paused, so one can
+ * go over the budget, and whatever it went over by is taken out of the ticks after it. Requests with the same start
+ * and goal as one that's still waiting are merged into it, and every requester collects its own copy of the path when
+ * it's done
+ *
+ * The worker keeps a few searches around and retargets one if it has the same start as the new request, so
+ * requesting a path from the start of a previous path is cheaper than requesting one from somewhere new
+ *
+ * The worker holds the queue's map_lock while it searches, and changes to the collidemap have to be made through
+ * path_queue_update_square() so they only happen between searches. A search that was paused across a change may
+ * still have been started on the old collidemap, so paths are handed back with the revision they were requested at
+ * so callers can check them. Hierarchical searches use the worker's own scratch space, so the main thread can still
+ * use map_pathfind() on the same map while the worker is searching
+ */
+
+typedef struct path_job{
+    int start;
+    int goal;
+    int revision;
+    pathfind_mode mode; // pathfind_active_mode when the job was requested, so the worker never has to read it
+    pathfind_status status; // PATHFIND_SEARCHING until the worker is done with it
+    path result;
+
+    int references; // requesters still waiting on this job, it's dropped once this hits 0
+    pathfind_search* search;
+    struct path_job* next;
+} path_job;
+
+typedef struct path_queue{
+    map* map;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_mutex_t map_lock; // held by the worker while it's searching and by anything changing the map
+    bool running;
+
+    int expansion_budget; // max squares the worker can expand each tick
+    int expansions_left; // below 0 while the worker is paying back a search that went over budget
+
+    path_job* pending; // oldest first, the worker always works on the first one
+    path_job* pending_last;
+    path_job* free_jobs;
+
+    // Searches owned by the worker, recycled least recently used first
+    pathfind_search** searches;
+    int* search_last_used;
+    int search_count;
+    int search_clock;
+    struct hpa_search* hpa_search; // the worker's scratch space for hierarchical searches
+} path_queue;
+
+path_queue* path_queue_create(map* the_map, int expansion_budget);
+void path_queue_free(path_queue* queue);
+void path_queue_tick(path_queue* queue); // gives the worker a fresh budget, call once at the start of every tick
+
+path_job* path_queue_request(path_queue* queue, vector start, vector goal);
+pathfind_status path_queue_collect(path_queue* queue, path_job* job, path* solution, int* revision); // if the job's done, copies out its path and lets go of the job
+void path_queue_cancel(path_queue* queue, path_job* job); // lets go of a job without waiting for it
+void path_queue_update_square(path_queue* queue, vector square); // map_update_collidemap() once the worker isn't searching
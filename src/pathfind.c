@@ -0,0 +1,612 @@
+#include "pathfind.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static const int direction_x[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+static const int direction_y[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+pathfind_mode pathfind_active_mode = PATHFIND_MODE_ASTAR;
+
+// Path
+
+void path_free(path* the_path){
+
+    free(the_path->squares);
+    the_path->squares = NULL;
+    the_path->length = 0;
+    the_path->capacity = 0;
+}
+
+void path_push(path* the_path, vector square){
+
+    if(the_path->length == the_path->capacity){
+
+        the_path->capacity = the_path->capacity == 0 ? 16 : the_path->capacity * 2;
+        the_path->squares = realloc(the_path->squares, sizeof(vector) * the_path->capacity);
+    }
+
+    the_path->squares[the_path->length] = square;
+    the_path->length++;
+}
+
+void path_copy(path* dest, path* source){
+
+    if(dest->capacity < source->length){
+
+        dest->capacity = source->length;
+        dest->squares = realloc(dest->squares, sizeof(vector) * dest->capacity);
+    }
+
+    memcpy(dest->squares, source->squares, sizeof(vector) * source->length);
+    dest->length = source->length;
+}
+
+int path_find_square(path* the_path, vector square, int from_index){
+
+    for(int i = from_index; i < the_path->length; i++){
+
+        if(the_path->squares[i].x == square.x && the_path->squares[i].y == square.y){
+
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Helpers
+
+static bool square_blocked(map* the_map, int x, int y){
+
+    if(x < 0 || x >= the_map->width || y < 0 || y >= the_map->height){
+
+        return true;
+    }
+
+    return the_map->collidemap[x + (y * the_map->width)];
+}
+
+// Since every move costs 1, the number of moves between two squares on an empty map is the larger of the two axis distances
+static int heuristic(pathfind_search* search, int index){
+
+    int width = search->map->width;
+    int dx = abs((index % width) - (search->goal % width));
+    int dy = abs((index / width) - (search->goal / width));
+
+    return dx > dy ? dx : dy;
+}
+
+// Returns true if a should come off the open heap before b
+// Ties go to the square with the greater cost since it's probably further along towards the goal
+static bool open_before(pathfind_search* search, int a, int b){
+
+    int score_a = search->cost[a] + heuristic(search, a);
+    int score_b = search->cost[b] + heuristic(search, b);
+    if(score_a != score_b){
+
+        return score_a < score_b;
+    }
+
+    return search->cost[a] > search->cost[b];
+}
+
+static void open_swap(pathfind_search* search, int i, int j){
+
+    int temp = search->open[i];
+    search->open[i] = search->open[j];
+    search->open[j] = temp;
+    search->open_index[search->open[i]] = i;
+    search->open_index[search->open[j]] = j;
+}
+
+static void open_sift_up(pathfind_search* search, int i){
+
+    while(i > 0){
+
+        int parent = (i - 1) / 2;
+        if(!open_before(search, search->open[i], search->open[parent])){
+
+            break;
+        }
+        open_swap(search, i, parent);
+        i = parent;
+    }
+}
+
+static void open_sift_down(pathfind_search* search, int i){
+
+    while(true){
+
+        int left = (i * 2) + 1;
+        int right = left + 1;
+        int smallest = i;
+        if(left < search->open_size && open_before(search, search->open[left], search->open[smallest])){
+
+            smallest = left;
+        }
+        if(right < search->open_size && open_before(search, search->open[right], search->open[smallest])){
+
+            smallest = right;
+        }
+        if(smallest == i){
+
+            break;
+        }
+        open_swap(search, i, smallest);
+        i = smallest;
+    }
+}
+
+static void open_push(pathfind_search* search, int index){
+
+    search->open[search->open_size] = index;
+    search->open_index[index] = search->open_size;
+    search->open_size++;
+    open_sift_up(search, search->open_size - 1);
+}
+
+static int open_pop(pathfind_search* search){
+
+    int index = search->open[0];
+    search->open_size--;
+    if(search->open_size != 0){
+
+        open_swap(search, 0, search->open_size);
+        open_sift_down(search, 0);
+    }
+    search->open_index[index] = -1;
+
+    return index;
+}
+
+// Adds child to the open heap, or updates it if this is a cheaper way there
+static void open_relax(pathfind_search* search, int current, int child, int child_cost){
+
+    if(search->seen[child] != search->generation){
+
+        search->seen[child] = search->generation;
+        search->cost[child] = child_cost;
+        search->parent[child] = current;
+        open_push(search, child);
+
+    }else if(search->open_index[child] != -1 && child_cost < search->cost[child]){
+
+        search->cost[child] = child_cost;
+        search->parent[child] = current;
+        open_sift_up(search, search->open_index[child]);
+    }
+}
+
+bool pathfind_move_allowed(map* the_map, int x, int y, int dx, int dy){
+
+    if(square_blocked(the_map, x + dx, y + dy)){
+
+        return false;
+    }
+
+    // If moving diagonally, make sure this movement isn't taking us through a wall corner
+    return dx == 0 || dy == 0 || (!square_blocked(the_map, x + dx, y) && !square_blocked(the_map, x, y + dy));
+}
+
+static void expand_neighbors(pathfind_search* search, int current){
+
+    map* the_map = search->map;
+    int width = the_map->width;
+    int current_x = current % width;
+    int current_y = current / width;
+
+    for(int direction = 0; direction < 8; direction++){
+
+        if(pathfind_move_allowed(the_map, current_x, current_y, direction_x[direction], direction_y[direction])){
+
+            int child = current_x + direction_x[direction] + ((current_y + direction_y[direction]) * width);
+            open_relax(search, current, child, search->cost[current] + 1);
+        }
+    }
+}
+
+// Jump point search
+// Rather than adding every neighbor to the open heap, JPS only follows the directions that a shortest path could take
+// coming from the parent square and then skips along each of them until it finds a square where the path might have to turn
+
+static int sign(int value){
+
+    return (value > 0) - (value < 0);
+}
+
+// Jump distances are stored in this order for each square
+static int straight_direction(int dx, int dy){
+
+    if(dx != 0){
+
+        return dx > 0 ? 0 : 1;
+    }
+
+    return dy > 0 ? 2 : 3;
+}
+
+// A side square that was walled off one step back can only be reached cheaply through this square, so a straight jump
+// moving in the direction (dx, dy) stops here
+static bool straight_jump_point(map* the_map, int x, int y, int dx, int dy){
+
+    if(dx != 0){
+
+        return (!square_blocked(the_map, x, y - 1) && square_blocked(the_map, x - dx, y - 1)) || (!square_blocked(the_map, x, y + 1) && square_blocked(the_map, x - dx, y + 1));
+    }
+
+    return (!square_blocked(the_map, x - 1, y) && square_blocked(the_map, x - 1, y - dy)) || (!square_blocked(the_map, x + 1, y) && square_blocked(the_map, x + 1, y - dy));
+}
+
+// Fills in the jump distances in the direction (dx, dy) for the line of squares through (x, y), walking back from the
+// far end so that each square's distance comes from the one after it
+// A distance above 0 is how many steps away the next jump point is, otherwise it's minus the number of steps before a wall
+static void build_jump_line(map* the_map, int x, int y, int dx, int dy){
+
+    int direction = straight_direction(dx, dy);
+    x = dx > 0 ? the_map->width - 1 : dx < 0 ? 0 : x;
+    y = dy > 0 ? the_map->height - 1 : dy < 0 ? 0 : y;
+
+    while(x >= 0 && x < the_map->width && y >= 0 && y < the_map->height){
+
+        int distance;
+        if(square_blocked(the_map, x + dx, y + dy)){
+
+            distance = 0;
+
+        }else if(straight_jump_point(the_map, x + dx, y + dy, dx, dy)){
+
+            distance = 1;
+
+        }else{
+
+            int next = the_map->jump_distances[((x + dx + ((y + dy) * the_map->width)) * 4) + direction];
+            distance = next > 0 ? next + 1 : next - 1;
+        }
+        the_map->jump_distances[((x + (y * the_map->width)) * 4) + direction] = distance;
+
+        x -= dx;
+        y -= dy;
+    }
+}
+
+void pathfind_build_jumps(map* the_map){
+
+    if(the_map->jump_distances == NULL){
+
+        the_map->jump_distances = malloc(sizeof(int16_t) * 4 * the_map->width * the_map->height);
+    }
+
+    for(int y = 0; y < the_map->height; y++){
+
+        build_jump_line(the_map, 0, y, 1, 0);
+        build_jump_line(the_map, 0, y, -1, 0);
+    }
+    for(int x = 0; x < the_map->width; x++){
+
+        build_jump_line(the_map, x, 0, 0, 1);
+        build_jump_line(the_map, x, 0, 0, -1);
+    }
+}
+
+// Whether a square is a jump point depends on the rows or columns either side of it, so those lines change too
+void pathfind_update_jumps(map* the_map, vector square){
+
+    for(int y = (int)square.y - 1; y <= (int)square.y + 1; y++){
+
+        if(y >= 0 && y < the_map->height){
+
+            build_jump_line(the_map, 0, y, 1, 0);
+            build_jump_line(the_map, 0, y, -1, 0);
+        }
+    }
+    for(int x = (int)square.x - 1; x <= (int)square.x + 1; x++){
+
+        if(x >= 0 && x < the_map->width){
+
+            build_jump_line(the_map, x, 0, 0, 1);
+            build_jump_line(the_map, x, 0, 0, -1);
+        }
+    }
+}
+
+// Looks up where a straight jump from (x, y) lands, unless the goal is on the way there
+static int jump_straight(pathfind_search* search, int x, int y, int dx, int dy){
+
+    map* the_map = search->map;
+    int width = the_map->width;
+    int distance = the_map->jump_distances[((x + (y * width)) * 4) + straight_direction(dx, dy)];
+    int reach = distance > 0 ? distance : -distance;
+
+    int goal_x = search->goal % width;
+    int goal_y = search->goal / width;
+    bool goal_in_line = dx != 0 ? goal_y == y : goal_x == x;
+    int goal_distance = dx != 0 ? (goal_x - x) * dx : (goal_y - y) * dy;
+    if(goal_in_line && goal_distance > 0 && goal_distance <= reach){
+
+        return search->goal;
+    }
+
+    if(distance <= 0){
+
+        return -1;
+    }
+
+    return x + (distance * dx) + ((y + (distance * dy)) * width);
+}
+
+static int jump_diagonal(pathfind_search* search, int x, int y, int dx, int dy){
+
+    map* the_map = search->map;
+
+    while(true){
+
+        if(!pathfind_move_allowed(the_map, x, y, dx, dy)){
+
+            return -1;
+        }
+        x += dx;
+        y += dy;
+
+        int index = x + (y * the_map->width);
+        if(index == search->goal){
+
+            return index;
+        }
+
+        // Moving diagonally, a square is a jump point if either of the straight directions it covers leads to one
+        if(jump_straight(search, x, y, dx, 0) != -1 || jump_straight(search, x, y, 0, dy) != -1){
+
+            return index;
+        }
+    }
+}
+
+static void jump_from(pathfind_search* search, int current, int dx, int dy){
+
+    int width = search->map->width;
+    int current_x = current % width;
+    int current_y = current / width;
+
+    int jump_point = dx != 0 && dy != 0 ? jump_diagonal(search, current_x, current_y, dx, dy) : jump_straight(search, current_x, current_y, dx, dy);
+    if(jump_point == -1){
+
+        return;
+    }
+
+    // Jumps only ever go in one direction, so the number of moves is the larger axis distance
+    int distance_x = abs((jump_point % width) - current_x);
+    int distance_y = abs((jump_point / width) - current_y);
+    open_relax(search, current, jump_point, search->cost[current] + (distance_x > distance_y ? distance_x : distance_y));
+}
+
+static void expand_jump_points(pathfind_search* search, int current){
+
+    map* the_map = search->map;
+    int width = the_map->width;
+    int current_x = current % width;
+    int current_y = current / width;
+
+    // The start square has no direction of travel, so everything around it is a candidate
+    if(search->parent[current] == -1){
+
+        for(int direction = 0; direction < 8; direction++){
+
+            jump_from(search, current, direction_x[direction], direction_y[direction]);
+        }
+        return;
+    }
+
+    int dx = sign(current_x - (search->parent[current] % width));
+    int dy = sign(current_y - (search->parent[current] / width));
+
+    if(dx != 0 && dy != 0){
+
+        jump_from(search, current, dx, 0);
+        jump_from(search, current, 0, dy);
+        jump_from(search, current, dx, dy);
+
+    }else if(dx != 0){
+
+        jump_from(search, current, dx, 0);
+        jump_from(search, current, dx, 1);
+        jump_from(search, current, dx, -1);
+        jump_from(search, current, 0, 1);
+        jump_from(search, current, 0, -1);
+
+    }else{
+
+        jump_from(search, current, 0, dy);
+        jump_from(search, current, 1, dy);
+        jump_from(search, current, -1, dy);
+        jump_from(search, current, 1, 0);
+        jump_from(search, current, -1, 0);
+    }
+}
+
+// Search
+
+pathfind_search* pathfind_search_create(map* the_map){
+
+    pathfind_search* search = malloc(sizeof(pathfind_search));
+
+    search->map = the_map;
+    search->map_size = the_map->width * the_map->height;
+    search->revision = -1;
+    search->start = -1;
+    search->goal = -1;
+    search->status = PATHFIND_IDLE;
+    search->mode = PATHFIND_MODE_ASTAR; // set properly when the search begins
+    search->nodes_expanded = 0;
+
+    search->generation = 0;
+    search->seen = calloc(search->map_size, sizeof(int));
+    search->cost = malloc(sizeof(int) * search->map_size);
+    search->parent = malloc(sizeof(int) * search->map_size);
+    search->open_index = malloc(sizeof(int) * search->map_size);
+
+    // Each square can only be in the open heap once, so it never needs to be bigger than the map
+    search->open = malloc(sizeof(int) * search->map_size);
+    search->open_size = 0;
+
+    return search;
+}
+
+void pathfind_search_free(pathfind_search* search){
+
+    free(search->seen);
+    free(search->cost);
+    free(search->parent);
+    free(search->open_index);
+    free(search->open);
+    free(search);
+}
+
+void pathfind_search_begin(pathfind_search* search, vector start, vector goal){
+
+    pathfind_search_begin_mode(search, start, goal, pathfind_active_mode);
+}
+
+void pathfind_search_begin_mode(pathfind_search* search, vector start, vector goal, pathfind_mode mode){
+
+    int width = search->map->width;
+
+    search->generation++;
+    search->mode = mode == PATHFIND_MODE_JPS ? PATHFIND_MODE_JPS : PATHFIND_MODE_ASTAR;
+    search->revision = search->map->collide_revision;
+    search->start = (int)start.x + ((int)start.y * width);
+    search->goal = (int)goal.x + ((int)goal.y * width);
+    search->nodes_expanded = 0;
+    search->open_size = 0;
+
+    // Fail straight away if the goal is in a different area, rather than searching every square that can be reached
+    // The revision is cleared too so that this empty search isn't mistaken for one that can be retargeted
+    if(!map_squares_connected(search->map, start, goal)){
+
+        search->revision = -1;
+        search->status = PATHFIND_FAILED;
+        return;
+    }
+
+    search->seen[search->start] = search->generation;
+    search->cost[search->start] = 0;
+    search->parent[search->start] = -1;
+    open_push(search, search->start);
+
+    search->status = PATHFIND_SEARCHING;
+}
+
+bool pathfind_search_retarget(pathfind_search* search, vector goal){
+
+    // Closed costs only hold if the map hasn't changed since they were found
+    // Jumps also skip straight over any square that wasn't the goal at the time, so JPS searches always have to start over
+    if(search->status == PATHFIND_IDLE || search->mode != PATHFIND_MODE_ASTAR || search->revision != search->map->collide_revision){
+
+        return false;
+    }
+
+    search->goal = (int)goal.x + ((int)goal.y * search->map->width);
+    search->nodes_expanded = 0;
+
+    vector start = (vector){ .x = search->start % search->map->width, .y = search->start / search->map->width };
+    if(!map_squares_connected(search->map, start, goal)){
+
+        search->status = PATHFIND_FAILED;
+        return true;
+    }
+
+    // If the new goal was already closed then its cost and parents are final
+    if(search->seen[search->goal] == search->generation && search->open_index[search->goal] == -1){
+
+        search->status = PATHFIND_FOUND;
+        return true;
+    }
+
+    // Otherwise the heuristic changed for every open square, so rebuild the heap with the new scores
+    for(int i = (search->open_size / 2) - 1; i >= 0; i--){
+
+        open_sift_down(search, i);
+    }
+    search->status = PATHFIND_SEARCHING;
+
+    return true;
+}
+
+pathfind_status pathfind_search_run(pathfind_search* search, int max_expansions){
+
+    int expansions = 0;
+
+    while(search->status == PATHFIND_SEARCHING){
+
+        if(search->open_size == 0){
+
+            search->status = PATHFIND_FAILED;
+            break;
+        }
+        if(max_expansions != 0 && expansions == max_expansions){
+
+            break;
+        }
+
+        // The goal is left on the open heap rather than closed, since it hasn't been expanded
+        // That way a retargeted search can carry on without missing anything past it
+        if(search->open[0] == search->goal){
+
+            search->status = PATHFIND_FOUND;
+            break;
+        }
+
+        int current = open_pop(search);
+        expansions++;
+        search->nodes_expanded++;
+
+        if(search->mode == PATHFIND_MODE_JPS){
+
+            expand_jump_points(search, current);
+
+        }else{
+
+            expand_neighbors(search, current);
+        }
+    }
+
+    return search->status;
+}
+
+bool pathfind_search_get_path(pathfind_search* search, path* solution){
+
+    if(search->status != PATHFIND_FOUND){
+
+        return false;
+    }
+
+    int width = search->map->width;
+    int length = search->cost[search->goal] + 1;
+    if(solution->capacity < length){
+
+        solution->capacity = length;
+        solution->squares = realloc(solution->squares, sizeof(vector) * solution->capacity);
+    }
+    solution->length = length;
+
+    // Walk back from the goal, filling the path in from the end
+    // Parents aren't always neighbors when jumping, but they're always in a straight or diagonal line so the squares between can be filled in
+    int x = search->goal % width;
+    int y = search->goal / width;
+    int parent = search->parent[search->goal];
+    for(int i = length - 1; i >= 0; i--){
+
+        solution->squares[i] = (vector){ .x = x, .y = y };
+        if(x + (y * width) == parent){
+
+            parent = search->parent[parent];
+        }
+        if(parent != -1){
+
+            x += sign((parent % width) - x);
+            y += sign((parent / width) - y);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "map.h"
+#include "vector.h"
+
+#include <stdbool.h>
+
+/*
+ * Grid search used by map_pathfind() and the enemy AI
+ *
+ * Squares are connected to all 8 neighbors at a cost of 1, but a diagonal move isn't allowed if it would cut
+ * through the corner of an occupied square
+ *
+ * A search keeps its open and closed sets after it finishes. As long as the map and the start square haven't changed,
+ * every closed square still has its shortest cost, so when the goal moves the search can be retargeted: the open set
+ * is re-keyed against the new goal and the search resumes from where it left off instead of starting over
+ *
+ * Only A* searches can be retargeted, JPS searches are always started over
+ *
+ * JPS doesn't scan along straight lines while it searches. The map keeps how far a straight jump goes from every
+ * square in each of the 4 directions, worked out from the collidemap when it's generated and redone for the rows and
+ * columns around a square when it changes (JPS+). A straight jump is then a lookup, and a diagonal one is a lookup
+ * per step. The distances are 16 bit, so maps can't be more than 32767 squares across
+ */
+
+typedef struct path{
+    vector* squares; // every square from the start to the goal, both included
+    int length;
+    int capacity;
+} path;
+
+typedef enum pathfind_mode{
+    PATHFIND_MODE_ASTAR,
+    PATHFIND_MODE_JPS, // jump point search, finds paths of the same length as A* while putting far fewer squares on the open heap
+    PATHFIND_MODE_HPA // hierarchical search through hpa.h, searches started through pathfind_search_begin() in this mode run A*
+} pathfind_mode;
+
+extern pathfind_mode pathfind_active_mode; // the mode new searches will use, only ever change it from the main thread
+
+typedef enum pathfind_status{
+    PATHFIND_IDLE,
+    PATHFIND_SEARCHING,
+    PATHFIND_FOUND,
+    PATHFIND_FAILED
+} pathfind_status;
+
+typedef struct pathfind_search{
+    map* map;
+    int map_size;
+    int revision; // the map's collide_revision when the search began
+
+    int start;
+    int goal;
+    pathfind_mode mode;
+    pathfind_status status;
+    int nodes_expanded;
+
+    // Per square data, only valid where seen[index] == generation so that nothing has to be cleared between searches
+    int generation;
+    int* seen;
+    int* cost;
+    int* parent;
+    int* open_index; // index into the open heap, or -1 once the square is closed
+
+    int* open;
+    int open_size;
+} pathfind_search;
+
+void path_free(path* the_path);
+void path_push(path* the_path, vector square);
+void path_copy(path* dest, path* source);
+int path_find_square(path* the_path, vector square, int from_index); // returns the index of square in the path or -1 if it isn't on it
+
+pathfind_search* pathfind_search_create(map* the_map);
+void pathfind_search_free(pathfind_search* search);
+void pathfind_search_begin(pathfind_search* search, vector start, vector goal); // starts a new search from scratch
+void pathfind_search_begin_mode(pathfind_search* search, vector start, vector goal, pathfind_mode mode); // pathfind_search_begin() in the given mode rather than the active one
+bool pathfind_search_retarget(pathfind_search* search, vector goal); // points an existing search at a new goal, returns false if the search can't be reused
+pathfind_status pathfind_search_run(pathfind_search* search, int max_expansions); // runs until the search finishes or has expanded max_expansions squares, 0 for no limit
+bool pathfind_search_get_path(pathfind_search* search, path* solution); // copies the found path into solution
+
+bool pathfind_move_allowed(map* the_map, int x, int y, int dx, int dy); // returns true if a single step from (x, y) in the direction (dx, dy) is allowed
+void pathfind_build_jumps(map* the_map); // works out the map's jump_distances from its collidemap, called by map_generate_collidemap()
+void pathfind_update_jumps(map* the_map, vector square); // redoes the jump_distances a change to the square's collision could affect
@@ -0,0 +1,188 @@
+#include "ray_packet.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define RAY_PACKET_X86 1
+#include <immintrin.h>
+#else
+#define RAY_PACKET_X86 0
+#endif
+
+int packet_lanes = 0; // 0 until it's been decided
+
+#if RAY_PACKET_X86
+
+// The same operations for each instruction set, so the traversal below only has to be written once
+#define SSE_FLOAT __m128
+#define SSE_LANES 4
+#define SSE_SET1(a) _mm_set1_ps(a)
+#define SSE_LOAD(pointer) _mm_loadu_ps(pointer)
+#define SSE_STORE(pointer, a) _mm_storeu_ps(pointer, a)
+#define SSE_ADD(a, b) _mm_add_ps(a, b)
+#define SSE_SUB(a, b) _mm_sub_ps(a, b)
+#define SSE_MUL(a, b) _mm_mul_ps(a, b)
+#define SSE_DIV(a, b) _mm_div_ps(a, b)
+#define SSE_SQRT(a) _mm_sqrt_ps(a)
+#define SSE_TRUNC(a) _mm_cvtepi32_ps(_mm_cvttps_epi32(a))
+#define SSE_EQ(a, b) _mm_cmpeq_ps(a, b)
+#define SSE_GT(a, b) _mm_cmpgt_ps(a, b)
+#define SSE_LE(a, b) _mm_cmple_ps(a, b)
+#define SSE_OR(a, b) _mm_or_ps(a, b)
+#define SSE_ANDNOT(mask, a) _mm_andnot_ps(mask, a)
+#define SSE_SELECT(mask, a, b) _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b))
+
+#define AVX_FLOAT __m256
+#define AVX_LANES 8
+#define AVX_SET1(a) _mm256_set1_ps(a)
+#define AVX_LOAD(pointer) _mm256_loadu_ps(pointer)
+#define AVX_STORE(pointer, a) _mm256_storeu_ps(pointer, a)
+#define AVX_ADD(a, b) _mm256_add_ps(a, b)
+#define AVX_SUB(a, b) _mm256_sub_ps(a, b)
+#define AVX_MUL(a, b) _mm256_mul_ps(a, b)
+#define AVX_DIV(a, b) _mm256_div_ps(a, b)
+#define AVX_SQRT(a) _mm256_sqrt_ps(a)
+#define AVX_TRUNC(a) _mm256_cvtepi32_ps(_mm256_cvttps_epi32(a))
+#define AVX_EQ(a, b) _mm256_cmp_ps(a, b, _CMP_EQ_OQ)
+#define AVX_GT(a, b) _mm256_cmp_ps(a, b, _CMP_GT_OQ)
+#define AVX_LE(a, b) _mm256_cmp_ps(a, b, _CMP_LE_OQ)
+#define AVX_OR(a, b) _mm256_or_ps(a, b)
+#define AVX_ANDNOT(mask, a) _mm256_andnot_ps(mask, a)
+#define AVX_SELECT(mask, a, b) _mm256_blendv_ps(b, a, mask)
+
+// Steps a full packet of rays from origin until every one of them hits a wall, filling in where each one hit and what
+// it hit. Each step is render_raycast()'s step with both branches worked out and the one it would take selected, so
+// every lane comes out exactly the same. A lane that's already hit keeps getting stepped along with the others, but
+// nothing it does after that is looked at
+#define RAY_PACKET_TRAVERSE(name, target, isa) \
+target static void name(State* state, vector origin, const vector* rays, vector* hits, int* textures){ \
+ \
+    float ray_x_lanes[isa##_LANES]; \
+    float ray_y_lanes[isa##_LANES]; \
+    for(int lane = 0; lane < isa##_LANES; lane++){ \
+ \
+        ray_x_lanes[lane] = rays[lane].x; \
+        ray_y_lanes[lane] = rays[lane].y; \
+    } \
+    isa##_FLOAT ray_x = isa##_LOAD(ray_x_lanes); \
+    isa##_FLOAT ray_y = isa##_LOAD(ray_y_lanes); \
+    isa##_FLOAT zero = isa##_SET1(0); \
+    isa##_FLOAT one = isa##_SET1(1); \
+    isa##_FLOAT ray_x_zero = isa##_EQ(ray_x, zero); \
+    isa##_FLOAT ray_y_zero = isa##_EQ(ray_y, zero); \
+    isa##_FLOAT ray_x_positive = isa##_GT(ray_x, zero); \
+    isa##_FLOAT ray_y_positive = isa##_GT(ray_y, zero); \
+ \
+    /* Every ray starts at the origin, so if it's in a wall they all stop there */ \
+    int running = (1 << isa##_LANES) - 1; \
+    int origin_hit = hits_wall(state, origin); \
+    if(origin_hit != -1){ \
+ \
+        for(int lane = 0; lane < isa##_LANES; lane++){ \
+ \
+            hits[lane] = origin; \
+            textures[lane] = origin_hit; \
+        } \
+        running = 0; \
+    } \
+ \
+    isa##_FLOAT current_x = isa##_SET1(origin.x); \
+    isa##_FLOAT current_y = isa##_SET1(origin.y); \
+    while(running != 0){ \
+ \
+        /* Distance to the next vertical grid line, and how far along y that is */ \
+        isa##_FLOAT whole_x = isa##_TRUNC(current_x); \
+        isa##_FLOAT on_line_x = isa##_SELECT(ray_x_positive, isa##_ADD(current_x, one), isa##_SUB(current_x, one)); \
+        isa##_FLOAT off_line_x = isa##_SELECT(ray_x_positive, isa##_TRUNC(isa##_ADD(current_x, one)), whole_x); \
+        isa##_FLOAT x_step_x = isa##_SUB(isa##_SELECT(isa##_EQ(current_x, whole_x), on_line_x, off_line_x), current_x); \
+        isa##_FLOAT x_step_y = isa##_DIV(ray_y, isa##_DIV(ray_x, x_step_x)); \
+        x_step_x = isa##_ANDNOT(ray_x_zero, x_step_x); \
+        x_step_y = isa##_ANDNOT(ray_x_zero, x_step_y); \
+ \
+        /* And to the next horizontal one */ \
+        isa##_FLOAT whole_y = isa##_TRUNC(current_y); \
+        isa##_FLOAT on_line_y = isa##_SELECT(ray_y_positive, isa##_ADD(current_y, one), isa##_SUB(current_y, one)); \
+        isa##_FLOAT off_line_y = isa##_SELECT(ray_y_positive, isa##_TRUNC(isa##_ADD(current_y, one)), whole_y); \
+        isa##_FLOAT y_step_y = isa##_SUB(isa##_SELECT(isa##_EQ(current_y, whole_y), on_line_y, off_line_y), current_y); \
+        isa##_FLOAT y_step_x = isa##_DIV(ray_x, isa##_DIV(ray_y, y_step_y)); \
+        y_step_x = isa##_ANDNOT(ray_y_zero, y_step_x); \
+        y_step_y = isa##_ANDNOT(ray_y_zero, y_step_y); \
+ \
+        /* Take whichever line is closer, or the only one a ray along an axis can reach */ \
+        isa##_FLOAT x_dist = isa##_SQRT(isa##_ADD(isa##_MUL(x_step_x, x_step_x), isa##_MUL(x_step_y, x_step_y))); \
+        isa##_FLOAT y_dist = isa##_SQRT(isa##_ADD(isa##_MUL(y_step_x, y_step_x), isa##_MUL(y_step_y, y_step_y))); \
+        isa##_FLOAT take_x = isa##_ANDNOT(ray_x_zero, isa##_OR(ray_y_zero, isa##_LE(x_dist, y_dist))); \
+        current_x = isa##_ADD(current_x, isa##_SELECT(take_x, x_step_x, y_step_x)); \
+        current_y = isa##_ADD(current_y, isa##_SELECT(take_x, x_step_y, y_step_y)); \
+ \
+        float current_x_lanes[isa##_LANES]; \
+        float current_y_lanes[isa##_LANES]; \
+        isa##_STORE(current_x_lanes, current_x); \
+        isa##_STORE(current_y_lanes, current_y); \
+        for(int lane = 0; lane < isa##_LANES; lane++){ \
+ \
+            if(running & (1 << lane)){ \
+ \
+                vector current = (vector){ .x = current_x_lanes[lane], .y = current_y_lanes[lane] }; \
+                int wall_hit = hits_wall(state, current); \
+                if(wall_hit != -1){ \
+ \
+                    hits[lane] = current; \
+                    textures[lane] = wall_hit; \
+                    running &= ~(1 << lane); \
+                } \
+            } \
+        } \
+    } \
+}
+
+RAY_PACKET_TRAVERSE(ray_packet_traverse_sse, , SSE)
+RAY_PACKET_TRAVERSE(ray_packet_traverse_avx, __attribute__((target("avx"))), AVX)
+
+#endif
+
+int ray_packet_lanes(){
+
+    if(packet_lanes == 0){
+
+#if RAY_PACKET_X86
+        __builtin_cpu_init();
+        packet_lanes = __builtin_cpu_supports("avx") ? 8 : 4;
+#else
+        packet_lanes = 1;
+#endif
+    }
+
+    return packet_lanes;
+}
+
+void render_raycast_packet(State* state, vector origin, const vector* rays, int count, int texture_size, float* wall_dists, int* texture_xs, bool* x_sideds, int* textures){
+
+    int lanes = ray_packet_lanes();
+    int cast = 0;
+
+#if RAY_PACKET_X86
+    vector hits[RAY_PACKET_MAX_LANES];
+    for(; lanes > 1 && cast + lanes <= count; cast += lanes){
+
+        if(lanes == 8){
+
+            ray_packet_traverse_avx(state, origin, rays + cast, hits, textures + cast);
+
+        }else{
+
+            ray_packet_traverse_sse(state, origin, rays + cast, hits, textures + cast);
+        }
+
+        for(int lane = 0; lane < lanes; lane++){
+
+            int i = cast + lane;
+            render_raycast_hit(origin, rays[i], hits[lane], texture_size, &wall_dists[i], &texture_xs[i], &x_sideds[i]);
+        }
+    }
+#endif
+
+    // Whatever doesn't fill a packet is cast one at a time
+    for(; cast < count; cast++){
+
+        render_raycast(state, origin, rays[cast], texture_size, &wall_dists[cast], &texture_xs[cast], &x_sideds[cast], &textures[cast]);
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "state.h"
+
+/*
+ * Casts the wall rays for neighbouring screen columns together, a packet at a time
+ *
+ * Rays next to each other cross almost the same grid lines, so a packet of them is stepped forward in SIMD lanes, one
+ * ray per lane, doing exactly the same float operations render_raycast() does. Each lane is checked against the map
+ * on its own and masked off once it hits a wall, and the packet keeps going until every lane has. The results are
+ * the same as casting each ray with render_raycast(), bit for bit
+ *
+ * Packets are 8 rays wide with AVX, 4 with SSE2, and on anything else every ray is cast on its own. Which one is used
+ * is decided the first time rays are cast, from what the CPU supports
+ */
+
+#define RAY_PACKET_MAX_LANES 8
+
+int ray_packet_lanes(); // how many rays go in each packet on this CPU, 1 if they're cast one at a time
+void render_raycast_packet(State* state, vector origin, const vector* rays, int count, int texture_size, float* wall_dists, int* texture_xs, bool* x_sideds, int* textures); // render_raycast() for count rays from the same origin, with the results in arrays
@@ -0,0 +1,116 @@
+#include "span.h"
+
+#include <stddef.h>
+
+// How each mode turns a texel into a screen colour. shade is the kernel's shade table
+#define SPAN_COLOR_LIT(texel) (texel)
+#define SPAN_COLOR_DARK(texel) (((texel) >> 1) & 8355711)
+#define SPAN_COLOR_FOG(texel) shade[texel]
+
+// keyed is a constant, so for the modes that aren't keyed keep is always 0 and the mask folds away
+#define SPAN_COLUMN(name, texel_type, shift, color, keyed) \
+static void name(uint32_t* restrict dest, int dest_pitch, int count, const void* texels, const uint32_t* restrict shade, uint32_t pos, uint32_t step){ \
+ \
+    const texel_type* restrict column = (const texel_type*)texels; \
+    for(int i = 0; i < count; i++){ \
+ \
+        texel_type texel = column[(pos >> 16) & ((1u << (shift)) - 1)]; \
+        uint32_t keep = (keyed) ? -(uint32_t)(texel == 0) : 0; \
+        *dest = (color(texel) & ~keep) | (*dest & keep); \
+        dest += dest_pitch; \
+        pos += step; \
+    } \
+}
+
+// Floor textures are stored with u along the column, so a texel's index is u plus v shifted up by the size
+#define SPAN_FLOOR(name, texel_type, shift, color) \
+static void name(uint32_t* restrict floor_dest, uint32_t* restrict ceil_dest, int count, const void* floor_texels, const void* ceil_texels, const uint32_t* restrict shade, uint32_t u, uint32_t v, uint32_t du, uint32_t dv){ \
+ \
+    const texel_type* restrict floor_texture = (const texel_type*)floor_texels; \
+    const texel_type* restrict ceil_texture = (const texel_type*)ceil_texels; \
+    for(int i = 0; i < count; i++){ \
+ \
+        uint32_t texture_x = (u >> (16 - (shift))) & ((1u << (shift)) - 1); \
+        uint32_t texture_y = (v >> (16 - (shift))) & ((1u << (shift)) - 1); \
+        uint32_t index = texture_x | (texture_y << (shift)); \
+        floor_dest[i] = color(floor_texture[index]); \
+        ceil_dest[i] = color(ceil_texture[index]); \
+        u += du; \
+        v += dv; \
+    } \
+}
+
+#define SPAN_SIZE_TABLE(name) { name##_0, name##_1, name##_2, name##_3, name##_4, name##_5, name##_6, name##_7, name##_8 }
+
+// One kernel for every size from 1 to 256, named with the size's shift on the end
+#define SPAN_COLUMN_SIZES(name, texel_type, color, keyed) \
+    SPAN_COLUMN(name##_0, texel_type, 0, color, keyed) \
+    SPAN_COLUMN(name##_1, texel_type, 1, color, keyed) \
+    SPAN_COLUMN(name##_2, texel_type, 2, color, keyed) \
+    SPAN_COLUMN(name##_3, texel_type, 3, color, keyed) \
+    SPAN_COLUMN(name##_4, texel_type, 4, color, keyed) \
+    SPAN_COLUMN(name##_5, texel_type, 5, color, keyed) \
+    SPAN_COLUMN(name##_6, texel_type, 6, color, keyed) \
+    SPAN_COLUMN(name##_7, texel_type, 7, color, keyed) \
+    SPAN_COLUMN(name##_8, texel_type, 8, color, keyed)
+
+#define SPAN_FLOOR_SIZES(name, texel_type, color) \
+    SPAN_FLOOR(name##_0, texel_type, 0, color) \
+    SPAN_FLOOR(name##_1, texel_type, 1, color) \
+    SPAN_FLOOR(name##_2, texel_type, 2, color) \
+    SPAN_FLOOR(name##_3, texel_type, 3, color) \
+    SPAN_FLOOR(name##_4, texel_type, 4, color) \
+    SPAN_FLOOR(name##_5, texel_type, 5, color) \
+    SPAN_FLOOR(name##_6, texel_type, 6, color) \
+    SPAN_FLOOR(name##_7, texel_type, 7, color) \
+    SPAN_FLOOR(name##_8, texel_type, 8, color)
+
+SPAN_COLUMN_SIZES(span_column_lit, uint32_t, SPAN_COLOR_LIT, 0)
+SPAN_COLUMN_SIZES(span_column_dark, uint32_t, SPAN_COLOR_DARK, 0)
+SPAN_COLUMN_SIZES(span_column_fog, uint8_t, SPAN_COLOR_FOG, 0)
+SPAN_COLUMN_SIZES(span_column_keyed, uint32_t, SPAN_COLOR_LIT, 1)
+SPAN_COLUMN_SIZES(span_column_fog_keyed, uint8_t, SPAN_COLOR_FOG, 1)
+
+SPAN_FLOOR_SIZES(span_floor_lit, uint32_t, SPAN_COLOR_LIT)
+SPAN_FLOOR_SIZES(span_floor_dark, uint32_t, SPAN_COLOR_DARK)
+SPAN_FLOOR_SIZES(span_floor_fog, uint8_t, SPAN_COLOR_FOG)
+
+// In the same order as span_mode
+const span_column_kernel SPAN_COLUMN_KERNELS[NUM_SPAN_MODES][SPAN_SIZE_COUNT] = {
+    SPAN_SIZE_TABLE(span_column_lit),
+    SPAN_SIZE_TABLE(span_column_dark),
+    SPAN_SIZE_TABLE(span_column_fog),
+    SPAN_SIZE_TABLE(span_column_keyed),
+    SPAN_SIZE_TABLE(span_column_fog_keyed)
+};
+
+const span_floor_kernel SPAN_FLOOR_KERNELS[NUM_SPAN_MODES][SPAN_SIZE_COUNT] = {
+    SPAN_SIZE_TABLE(span_floor_lit),
+    SPAN_SIZE_TABLE(span_floor_dark),
+    SPAN_SIZE_TABLE(span_floor_fog),
+    { NULL },
+    { NULL }
+};
+
+int span_size_shift(int size){
+
+    for(int shift = SPAN_MIN_SHIFT; shift <= SPAN_MAX_SHIFT; shift++){
+
+        if(size == 1 << shift){
+
+            return shift;
+        }
+    }
+
+    return -1;
+}
+
+span_column_kernel span_get_column(span_mode mode, int shift){
+
+    return SPAN_COLUMN_KERNELS[mode][shift - SPAN_MIN_SHIFT];
+}
+
+span_floor_kernel span_get_floor(span_mode mode, int shift){
+
+    return SPAN_FLOOR_KERNELS[mode][shift - SPAN_MIN_SHIFT];
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * The inner loops that put textures on the screen, one for every texture size and way of shading
+ *
+ * Each kernel is written once as a macro and stamped out for every power of two size from 1 to 256, so the size is
+ * a constant in the loop and wrapping a texture coordinate is a mask and a shift. The renderer picks the kernel once
+ * per wall column, floor span or sprite column and the loop itself never checks the shading mode or the size
+ *
+ * Texture coordinates are 16.16 fixed point in texels of the size being drawn, and step by a fixed amount each pixel.
+ * Keyed modes leave the pixel alone where the texel is 0, which is both the transparent colour and palette index 0,
+ * by masking rather than branching
+ */
+
+#define SPAN_MIN_SHIFT 0
+#define SPAN_MAX_SHIFT 8 // 256 texels
+#define SPAN_SIZE_COUNT (SPAN_MAX_SHIFT - SPAN_MIN_SHIFT + 1)
+
+typedef enum span_mode{
+    SPAN_LIT, // colours as they are
+    SPAN_DARK, // colours at half brightness, for the sides of walls facing away from the light and the floor
+    SPAN_FOG, // palette indices looked up in a shade table
+    SPAN_KEYED, // colours, skipping transparent texels
+    SPAN_FOG_KEYED, // palette indices looked up in a shade table, skipping index 0
+    NUM_SPAN_MODES
+} span_mode;
+
+// Draws count pixels down a column, dest_pitch pixels apart, from a column major texture column starting at texture position pos
+typedef void (*span_column_kernel)(uint32_t* dest, int dest_pitch, int count, const void* texels, const uint32_t* shade, uint32_t pos, uint32_t step);
+
+// Draws count pixels along a floor row and the ceiling row mirroring it, both from the same texture coordinates in one cell
+typedef void (*span_floor_kernel)(uint32_t* floor_dest, uint32_t* ceil_dest, int count, const void* floor_texels, const void* ceil_texels, const uint32_t* shade, uint32_t u, uint32_t v, uint32_t du, uint32_t dv);
+
+int span_size_shift(int size); // returns log2 of size, or -1 if there are no kernels for it
+span_column_kernel span_get_column(span_mode mode, int shift);
+span_floor_kernel span_get_floor(span_mode mode, int shift); // floors are never keyed, so returns NULL for the keyed modes
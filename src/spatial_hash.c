@@ -0,0 +1,242 @@
+#include "spatial_hash.h"
+#include "vector_array.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+// Positions off the edge of the map are kept in the nearest edge square
+static int cell_coordinate(float position, int size){
+
+    int coordinate = (int)floor(position);
+    if(coordinate < 0){
+
+        return 0;
+    }
+    if(coordinate >= size){
+
+        return size - 1;
+    }
+    return coordinate;
+}
+
+static int cell_at(spatial_hash* hash, vector position){
+
+    return cell_coordinate(position.x, hash->width) + (cell_coordinate(position.y, hash->height) * hash->width);
+}
+
+static void cell_link(spatial_hash* hash, int entry, int cell){
+
+    spatial_entry* current = &hash->entries[entry];
+    current->cell = cell;
+    current->previous = -1;
+    current->next = hash->cells[cell];
+    if(current->next != -1){
+
+        hash->entries[current->next].previous = entry;
+    }
+    hash->cells[cell] = entry;
+}
+
+static void cell_unlink(spatial_hash* hash, int entry){
+
+    spatial_entry* current = &hash->entries[entry];
+    if(current->previous != -1){
+
+        hash->entries[current->previous].next = current->next;
+
+    }else{
+
+        hash->cells[current->cell] = current->next;
+    }
+    if(current->next != -1){
+
+        hash->entries[current->next].previous = current->previous;
+    }
+}
+
+static void results_push(spatial_hash* hash, int owner){
+
+    vector_array_push((void**)&hash->results, &owner, &hash->result_count, &hash->result_capacity, sizeof(int));
+}
+
+// Results are usually only a handful long, so insertion sort is plenty
+static void results_sort(spatial_hash* hash){
+
+    for(int i = 1; i < hash->result_count; i++){
+
+        int owner = hash->results[i];
+        int j = i - 1;
+        while(j >= 0 && hash->results[j] > owner){
+
+            hash->results[j + 1] = hash->results[j];
+            j--;
+        }
+        hash->results[j + 1] = owner;
+    }
+}
+
+spatial_hash* spatial_hash_create(int width, int height){
+
+    spatial_hash* hash = malloc(sizeof(spatial_hash));
+    hash->width = width;
+    hash->height = height;
+    hash->cells = malloc(sizeof(int) * width * height);
+    for(int i = 0; i < width * height; i++){
+
+        hash->cells[i] = -1;
+    }
+
+    hash->entry_capacity = 16;
+    hash->entry_count = 0;
+    hash->entries = malloc(sizeof(spatial_entry) * hash->entry_capacity);
+    hash->free_entry = -1;
+
+    hash->result_capacity = 16;
+    hash->result_count = 0;
+    hash->results = malloc(sizeof(int) * hash->result_capacity);
+
+    return hash;
+}
+
+void spatial_hash_free(spatial_hash* hash){
+
+    free(hash->cells);
+    free(hash->entries);
+    free(hash->results);
+    free(hash);
+}
+
+int spatial_hash_insert(spatial_hash* hash, vector position, int owner){
+
+    int entry = hash->free_entry;
+    if(entry != -1){
+
+        hash->free_entry = hash->entries[entry].next;
+
+    }else{
+
+        spatial_entry blank;
+        vector_array_push((void**)&hash->entries, &blank, &hash->entry_count, &hash->entry_capacity, sizeof(spatial_entry));
+        entry = hash->entry_count - 1;
+    }
+
+    hash->entries[entry].position = position;
+    hash->entries[entry].owner = owner;
+    cell_link(hash, entry, cell_at(hash, position));
+
+    return entry;
+}
+
+void spatial_hash_remove(spatial_hash* hash, int entry){
+
+    cell_unlink(hash, entry);
+    hash->entries[entry].owner = -1;
+    hash->entries[entry].next = hash->free_entry;
+    hash->free_entry = entry;
+}
+
+void spatial_hash_move(spatial_hash* hash, int entry, vector position){
+
+    hash->entries[entry].position = position;
+
+    int cell = cell_at(hash, position);
+    if(cell != hash->entries[entry].cell){
+
+        cell_unlink(hash, entry);
+        cell_link(hash, entry, cell);
+    }
+}
+
+void spatial_hash_set_owner(spatial_hash* hash, int entry, int owner){
+
+    hash->entries[entry].owner = owner;
+}
+
+// Finds every entry within radius of center and, if min_cosine isn't below -1, inside the cone along direction too
+static int query(spatial_hash* hash, vector center, float radius, vector direction, float min_cosine){
+
+    hash->result_count = 0;
+
+    int low_x = cell_coordinate(center.x - radius, hash->width);
+    int high_x = cell_coordinate(center.x + radius, hash->width);
+    int low_y = cell_coordinate(center.y - radius, hash->height);
+    int high_y = cell_coordinate(center.y + radius, hash->height);
+    for(int y = low_y; y <= high_y; y++){
+
+        for(int x = low_x; x <= high_x; x++){
+
+            for(int entry = hash->cells[x + (y * hash->width)]; entry != -1; entry = hash->entries[entry].next){
+
+                vector offset = vector_sub(hash->entries[entry].position, center);
+                float distance = vector_magnitude(offset);
+                if(distance > radius){
+
+                    continue;
+                }
+
+                // Compared by cosine so that the cone doesn't break where angles wrap around
+                if(min_cosine >= -1 && distance != 0 && ((offset.x * direction.x) + (offset.y * direction.y)) / distance < min_cosine){
+
+                    continue;
+                }
+
+                results_push(hash, hash->entries[entry].owner);
+            }
+        }
+    }
+
+    results_sort(hash);
+    return hash->result_count;
+}
+
+int spatial_hash_query_radius(spatial_hash* hash, vector center, float radius){
+
+    return query(hash, center, radius, ZERO_VECTOR, -2);
+}
+
+int spatial_hash_query_cone(spatial_hash* hash, vector origin, vector direction, float radius, float half_angle){
+
+    return query(hash, origin, radius, vector_scale(direction, 1), cos(half_angle * (PI / 180)));
+}
+
+int spatial_hash_nearest(spatial_hash* hash, vector position, float max_radius, int exclude_owner){
+
+    int center_x = cell_coordinate(position.x, hash->width);
+    int center_y = cell_coordinate(position.y, hash->height);
+    int nearest = -1;
+    float nearest_distance = max_radius;
+
+    // Search rings of squares outwards, everything in a ring is at least ring - 1 away so stop once that's too far
+    for(int ring = 0; ring <= (int)ceil(max_radius) + 1 && ring - 1 <= nearest_distance; ring++){
+
+        for(int y = center_y - ring; y <= center_y + ring; y++){
+
+            if(y < 0 || y >= hash->height){
+
+                continue;
+            }
+
+            // Squares inside the ring were already searched, so only step along its edges
+            int step = y == center_y - ring || y == center_y + ring ? 1 : max(ring * 2, 1);
+            for(int x = center_x - ring; x <= center_x + ring; x += step){
+
+                if(x < 0 || x >= hash->width){
+
+                    continue;
+                }
+
+                for(int entry = hash->cells[x + (y * hash->width)]; entry != -1; entry = hash->entries[entry].next){
+
+                    float distance = vector_distance(hash->entries[entry].position, position);
+                    if(hash->entries[entry].owner != exclude_owner && distance <= nearest_distance && (nearest == -1 || distance < nearest_distance || hash->entries[entry].owner < nearest)){
+
+                        nearest = hash->entries[entry].owner;
+                        nearest_distance = distance;
+                    }
+                }
+            }
+        }
+    }
+
+    return nearest;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vector.h"
+
+#include <stdbool.h>
+
+/*
+ * Uniform grid of map squares for finding the things near a point without checking every one of them
+ *
+ * Every entry is linked into the list of the square it's standing in, and only gets moved to another list when it
+ * crosses into a different square, so keeping the grid up to date is cheap. Queries only look at the squares that
+ * the area being searched overlaps, so their cost depends on how crowded that area is rather than how many entries
+ * there are overall
+ *
+ * Entries carry an owner, which is whatever the caller uses to find the thing again, like its index in an array.
+ * Queries write the owners they find to the hash's results array in ascending order
+ */
+
+typedef struct spatial_entry{
+    vector position;
+    int owner; // -1 if this entry isn't in use
+    int cell;
+    int next; // next entry in the same cell, -1 at the end of the list. Also links the free list
+    int previous;
+} spatial_entry;
+
+typedef struct spatial_hash{
+    int width;
+    int height;
+    int* cells; // first entry in each square, -1 if it's empty
+
+    spatial_entry* entries;
+    int entry_count;
+    int entry_capacity;
+    int free_entry; // first unused entry, -1 if there isn't one
+
+    int* results;
+    int result_count;
+    int result_capacity;
+} spatial_hash;
+
+spatial_hash* spatial_hash_create(int width, int height);
+void spatial_hash_free(spatial_hash* hash);
+
+int spatial_hash_insert(spatial_hash* hash, vector position, int owner); // returns the new entry's id
+void spatial_hash_remove(spatial_hash* hash, int entry);
+void spatial_hash_move(spatial_hash* hash, int entry, vector position);
+void spatial_hash_set_owner(spatial_hash* hash, int entry, int owner);
+
+int spatial_hash_query_radius(spatial_hash* hash, vector center, float radius); // finds every entry within radius of center, returns the number found
+int spatial_hash_query_cone(spatial_hash* hash, vector origin, vector direction, float radius, float half_angle); // same as radius, but only entries within half_angle degrees of direction
+int spatial_hash_nearest(spatial_hash* hash, vector position, float max_radius, int exclude_owner); // returns the owner of the closest entry within max_radius, or -1 if there isn't one
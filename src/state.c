@@ -21,13 +21,47 @@ const int PLAYER_ANIMATION_SPELLCAST_FRAMES = 4;
 const int PLAYER_OFFSET_X_MAX = 4;
 const int PLAYER_OFFSET_Y_MAX = 4;
 
+// Entity limits, the entity arrays are allocated at these sizes up front and never grow
+const int ENEMY_CAPACITY = 1024;
+const int PROJECTILE_CAPACITY = 256;
+const int PARTICLE_CAPACITY = 16384;
+
+// Spell effect constants
+const int BOLT_TRAIL_PARTICLES = 2; // left behind by each bolt every tick
+const int BOLT_SPARK_PARTICLES = 32; // thrown off when a bolt hits something
+const int KINETIC_PARTICLES = 256;
+
+// Enemy pathfinding constants
+const int ENEMY_PATHFIND_BUDGET = 2000; // squares the path queue can expand each tick
+
+// Enemy update constants
+const int ENEMY_UPDATE_THREADS = 3; // on top of the main thread
+const int ENEMY_UPDATE_CHUNK = 64; // enemies handed to a thread at a time
+
+// Enemy level of detail constants
+const float ENEMY_TIER_NEAR_DISTANCE = 8.0;
+const float ENEMY_TIER_SIGHT_DISTANCE = 32.0; // enemies further than this can't see the player
+const int ENEMY_TIER_PERIODS[NUM_ENEMY_TIERS] = { 1, 2, 4, 8 }; // an enemy in each tier is updated once every this many ticks
+
+typedef struct enemy_update_job{
+    State* state;
+    float delta;
+} enemy_update_job;
+
 // Init
 State* state_init(){
 
     State* new_state = (State*)malloc(sizeof(State));
 
+    new_state->tick = 0;
+    new_state->timers = timer_wheel_create();
+    new_state->timer_remainder = 0;
+
     // new_state->map = map_init(20, 15);
     new_state->map = map_load_from_tmx("./tiled/test.tmx");
+    new_state->path_queue = path_queue_create(new_state->map, ENEMY_PATHFIND_BUDGET);
+    new_state->sight = line_of_sight_create(new_state->map);
+    new_state->workers = worker_pool_create(ENEMY_UPDATE_THREADS);
 
     new_state->player_position = (vector){ .x = 2.5, .y = 2.5 };
     new_state->player_velocity = ZERO_VECTOR;
@@ -36,25 +70,29 @@ State* state_init(){
     new_state->player_camera = (vector){ .x = 0.66, .y = 0 };
     new_state->player_rotate_dir = 0;
 
-    new_state->player_knockback_timer = 0;
+    new_state->player_knockback_timer = -1;
 
     new_state->player_spell_selection = 0;
 
     new_state->player_animation_state = PLAYER_ANIMATION_STATE_IDLE;
-    new_state->player_animation_frame = 0;
-    new_state->player_animation_timer = 0.0;
+    new_state->player_animation_start = 0;
+    new_state->player_animation_timer = -1;
 
-    new_state->projectile_capacity = 10;
-    new_state->projectile_count = 0;
-    new_state->projectiles = malloc(sizeof(projectile) * new_state->projectile_capacity);
+    projectile_list_init(&new_state->projectiles, PROJECTILE_CAPACITY);
+    particle_list_init(&new_state->particles, PARTICLE_CAPACITY);
 
     new_state->object_capacity = 10;
     new_state->object_count = 0;
     new_state->objects = malloc(sizeof(sprite) * new_state->object_capacity);
 
-    new_state->enemy_capacity = 10;
-    new_state->enemy_count = 0;
-    new_state->enemies = malloc(sizeof(enemy) * new_state->enemy_capacity);
+    enemy_list_init(&new_state->enemies, ENEMY_CAPACITY);
+
+    new_state->object_hash = spatial_hash_create(new_state->map->width, new_state->map->height);
+    new_state->enemy_hash = spatial_hash_create(new_state->map->width, new_state->map->height);
+    for(int tier = 0; tier < NUM_ENEMY_TIERS; tier++){
+
+        new_state->enemy_tier_counts[tier] = 0;
+    }
 
     for(int x = 0; x < new_state->map->width; x++){
 
@@ -68,6 +106,7 @@ State* state_init(){
                     .position = (vector){ .x = x + 0.5, .y = y + 0.5 }
                 };
                 vector_array_push((void**)&(new_state->objects), &to_push, &new_state->object_count, &new_state->object_capacity, sizeof(sprite));
+                spatial_hash_insert(new_state->object_hash, to_push.position, new_state->object_count - 1);
             }
 
             int entity = new_state->map->entities[x + (y * new_state->map->width)];
@@ -77,16 +116,14 @@ State* state_init(){
 
             }else if(entity == 2){
 
-                enemy to_push = (enemy){
-                    .name = ENEMY_SLIME,
-                    .state = ENEMY_STATE_IDLE,
-                    .current_frame = 0,
-                    .animation_timer = 0,
-                    .position = (vector){ .x = x + 0.5, .y = y + 0.5 },
-                    .velocity = ZERO_VECTOR,
-                    .health = 3
-                };
-                vector_array_push((void**)&(new_state->enemies), &to_push, &new_state->enemy_count, &new_state->enemy_capacity, sizeof(enemy));
+                vector position = (vector){ .x = x + 0.5, .y = y + 0.5 };
+                int index = enemy_list_add(&new_state->enemies, ENEMY_SLIME, position);
+                if(index == -1){
+
+                    printf("Error! The map has more than %i enemies\n", ENEMY_CAPACITY);
+                    continue;
+                }
+                new_state->enemies.hash_entry[index] = spatial_hash_insert(new_state->enemy_hash, position, index);
             }
         }
     }
@@ -96,8 +133,42 @@ State* state_init(){
 
 // Updates
 
+static void enemy_cancel_timer(State* state, int index){
+
+    if(state->enemies.animation_timer[index] != -1){
+
+        timer_wheel_cancel(state->timers, state->enemies.animation_timer[index]);
+        state->enemies.animation_timer[index] = -1;
+    }
+}
+
+static void enemy_update_range(void* data, int begin, int end){
+
+    enemy_update_job* job = (enemy_update_job*)data;
+    for(int i = begin; i < end; i++){
+
+        if(enemy_is_due(job->state, i)){
+
+            enemy_update(job->state, i, job->delta);
+
+        }else{
+
+            job->state->enemies.step[i] = ZERO_VECTOR;
+        }
+    }
+}
+
 void state_update(State* state, float delta){
 
+    path_queue_tick(state->path_queue);
+
+    // Run the timers forward by however many whole units of time have passed
+    state->timer_remainder += delta;
+    int timer_time = (int)state->timer_remainder;
+    state->timer_remainder -= timer_time;
+    timer_wheel_advance(state->timers, timer_time);
+    state_handle_timers(state);
+
     // Rotate player and player camera
     float rotation_amount = PLAYER_ROTATE_SPEED * state->player_rotate_dir * delta;
     state->player_rotate_dir = 0; // Always reset each frame otherwise they will keep rotating
@@ -107,210 +178,524 @@ void state_update(State* state, float delta){
     bool player_inputs_movement = state->player_move_dir.x != 0 || state->player_move_dir.y != 0;
 
     // Player movement
+    // While knocked back the player keeps going the way they were pushed until the knockback's timer fires
     vector player_last_pos = state->player_position;
-    if(state->player_knockback_timer != 0){
+    if(state->player_knockback_timer == -1){
+
+        if(player_inputs_movement){
 
-        state->player_knockback_timer -= delta;
-        if(state->player_knockback_timer <= 0){
+            // Move player
+            float move_angle = atan2(-state->player_move_dir.y, -state->player_move_dir.x) - (PI / 2);
+            state->player_velocity = vector_mult(vector_scale(vector_rotate(state->player_direction, move_angle), PLAYER_SPEED), delta);
+
+        }else{
 
-            state->player_knockback_timer = 0;
             state->player_velocity = ZERO_VECTOR;
         }
+    }
 
-    }else if(player_inputs_movement){
+    state->player_position = vector_sum(state->player_position, state->player_velocity);
 
-        // Move player
-        float move_angle = atan2(-state->player_move_dir.y, -state->player_move_dir.x) - (PI / 2);
-        state->player_velocity = vector_mult(vector_scale(vector_rotate(state->player_direction, move_angle), PLAYER_SPEED), delta);
+    // Collisions, hitting a wall stops a knockback
+    if(check_wall_collisions(state, &(state->player_position), player_last_pos, state->player_velocity) && state->player_knockback_timer != -1){
 
-    }else{
+        timer_wheel_cancel(state->timers, state->player_knockback_timer);
+        state->player_knockback_timer = -1;
+    }
 
-        state->player_velocity = ZERO_VECTOR;
+    // Anything the player could have been pushed back into is within the collision distance plus however far they moved
+    float player_reach = 0.2 + vector_magnitude(state->player_velocity);
+    int nearby_count = spatial_hash_query_radius(state->object_hash, state->player_position, player_reach);
+    for(int i = 0; i < nearby_count; i++){
+
+        check_sprite_collision(&(state->player_position), player_last_pos, state->player_velocity, state->objects[state->object_hash->results[i]].position, 0.2);
     }
+    nearby_count = spatial_hash_query_radius(state->enemy_hash, state->player_position, player_reach);
+    for(int i = 0; i < nearby_count; i++){
 
-    state->player_position = vector_sum(state->player_position, state->player_velocity);
+        check_sprite_collision(&(state->player_position), player_last_pos, state->player_velocity, state->enemies.position[state->enemy_hash->results[i]], 0.2);
+    }
 
-    // Collisions
-    if(state->player_knockback_timer != 0 && in_wall(state, state->player_position)){
+    // Player animation update, the spellcast is ended by its timer
+    if(state->player_animation_state != PLAYER_ANIMATION_STATE_SPELLCAST){
 
-        state->player_knockback_timer = 0;
+        int animation_state = player_inputs_movement ? PLAYER_ANIMATION_STATE_WALK : PLAYER_ANIMATION_STATE_IDLE;
+        if(animation_state != state->player_animation_state){
+
+            state->player_animation_state = animation_state;
+            state->player_animation_start = state->timers->now;
+        }
     }
-    check_wall_collisions(state, &(state->player_position), player_last_pos, state->player_velocity);
 
-    for(int i = 0; i < state->object_count; i++){
+    // Projectile movement
+    // Each projectile's whole move is swept against the walls and the enemies before they're all moved, so however fast
+    // it's going it's used up on whatever it reaches first
+    projectile_list* projectiles = &state->projectiles;
+    for(int i = 0; i < projectiles->store.count; i++){
+
+        vector position = projectiles->position[i];
+        vector velocity = projectiles->velocity[i];
+        if(velocity.x == 0 && velocity.y == 0){
+
+            continue;
+        }
+
+        sweep_hit wall_hit = sweep_segment(state->map, position, velocity);
+
+        // Any enemy the move could touch is within the collision distance of some point along it
+        int hit_enemy = -1;
+        float hit_time = wall_hit.time;
+        float reach = (vector_magnitude(velocity) / 2) + 0.2;
+        int nearby_count = spatial_hash_query_radius(state->enemy_hash, vector_sum(position, vector_mult(velocity, 0.5)), reach);
+        for(int j = 0; j < nearby_count; j++){
+
+            int enemy = state->enemy_hash->results[j];
+            float time = sweep_circle(position, velocity, state->enemies.position[enemy], 0.2);
+            if(time != -1 && (time < hit_time || (hit_enemy == -1 && time <= hit_time))){
+
+                hit_enemy = enemy;
+                hit_time = time;
+            }
+        }
+
+        if(hit_enemy != -1 || wall_hit.hit){
+
+            // Sparks fly back off whatever it hit
+            vector impact = vector_sum(position, vector_mult(velocity, hit_time));
+            particle_burst(&state->particles, PARTICLE_BOLT_SPARK, impact, 0, vector_mult(velocity, -0.2), 0.04, BOLT_SPARK_PARTICLES, 25.0);
+            entity_store_remove(&projectiles->store, i);
+            if(hit_enemy != -1){
+
+                enemy_injure(state, hit_enemy, 1, ZERO_VECTOR, 10.0);
+            }
 
-        check_sprite_collision(&(state->player_position), player_last_pos, state->player_velocity, state->objects[i].position, 0.2);
+        }else{
+
+            particle_burst(&state->particles, PARTICLE_BOLT_TRAIL, position, 0, ZERO_VECTOR, 0.005, BOLT_TRAIL_PARTICLES, 20.0);
+        }
     }
-    for(int i = 0; i < state->enemy_count; i++){
+    entity_integrate(projectiles->position, projectiles->velocity, projectiles->store.count);
+
+    // Particles only ever get in the way of the walls, so they're moved and finished all at once
+    particle_list_update(&state->particles, state->map);
+
+    // Enemy update
+    // Every enemy decides where it's going, then they all move at once, then each one is pushed back out of whatever it ran into
+    // Deciding only reads what the others were doing at the start of the tick, so it's split across the worker pool, and
+    // anything that touches shared state, like the path queue, is done before or afterwards in enemy order so the result
+    // is the same however it was split
+    enemy_list* enemies = &state->enemies;
+
+    // Every enemy due an update looks for the player first, all in one batch, and picks up any path that's been found for it
+    line_of_sight_clear(state->sight);
+    for(int i = 0; i < enemies->store.count; i++){
+
+        if(enemy_is_due(state, i)){
 
-        check_sprite_collision(&(state->player_position), player_last_pos, state->player_velocity, state->enemies[i].position, 0.2);
+            line_of_sight_request(state->sight, state->player_position, enemies->position[i], ENEMY_TIER_SIGHT_DISTANCE);
+            enemy_collect_path(state, i);
+        }
     }
+    line_of_sight_resolve(state->sight, state->workers);
+    int sight_query = 0;
+    for(int i = 0; i < enemies->store.count; i++){
 
-    // Player animation update
-    if(state->player_animation_state != PLAYER_ANIMATION_STATE_SPELLCAST){
+        if(enemy_is_due(state, i)){
 
-        state->player_animation_state = player_inputs_movement ? PLAYER_ANIMATION_STATE_WALK : PLAYER_ANIMATION_STATE_IDLE;
+            enemies->sees_player[i] = state->sight->queries[sight_query].visible;
+            sight_query++;
+        }
     }
-    if(state->player_animation_state == PLAYER_ANIMATION_STATE_IDLE){
 
-        state->player_animation_timer = 0;
+    enemy_update_job update_job = (enemy_update_job){ .state = state, .delta = delta };
+    worker_pool_run(state->workers, enemy_update_range, &update_job, enemies->store.count, ENEMY_UPDATE_CHUNK);
 
-    }else if(state->player_animation_state == PLAYER_ANIMATION_STATE_WALK){
+    vector goal_square = (vector){ .x = (int)state->player_position.x, .y = (int)state->player_position.y };
+    for(int tier = 0; tier < NUM_ENEMY_TIERS; tier++){
 
-        state->player_animation_timer += delta;
-        if(state->player_animation_timer >= PLAYER_ANIMATION_WALK_DURATION){
+        state->enemy_tier_counts[tier] = 0;
+    }
+    for(int i = 0; i < enemies->store.count; i++){
 
-            state->player_animation_timer -= PLAYER_ANIMATION_WALK_DURATION;
+        state->enemy_tier_counts[enemies->tier[i]]++;
+        if(enemies->path_cancelled[i] != NULL){
+
+            path_queue_cancel(state->path_queue, enemies->path_cancelled[i]);
+            enemies->path_cancelled[i] = NULL;
         }
+        if(enemies->health[i] <= 0){
 
-    }else if(state->player_animation_state == PLAYER_ANIMATION_STATE_SPELLCAST){
+            entity_store_remove(&enemies->store, i);
 
-        state->player_animation_timer += delta;
-        if(state->player_animation_timer >= PLAYER_ANIMATION_SPELLCAST_DURATION){
+            continue;
+        }
 
-            state->player_animation_frame++;
-            if(state->player_animation_frame == PLAYER_ANIMATION_SPELLCAST_FRAMES){
+        if(enemies->path_requested[i]){
 
-                state->player_animation_state = PLAYER_ANIMATION_STATE_IDLE;
-                state->player_animation_frame = 0;
-                state->player_animation_timer = 0;
-                player_cast_finish(state);
+            enemies->path_job[i] = path_queue_request(state->path_queue, enemies->path_request_start[i], goal_square);
+            enemies->path_requested[i] = false;
+        }
 
-            }else{
+        // Attacks are started during the enemy update but their timers are set here, so they're made in enemy order
+        if(enemies->state[i] == ENEMY_STATE_ATTACKING && enemies->animation_timer[i] == -1){
 
-                state->player_animation_timer -= PLAYER_ANIMATION_SPELLCAST_DURATION;
-            }
+            enemy_data* current_info = &enemy_info[enemies->name[i]];
+            enemies->animation_timer[i] = timer_wheel_schedule(state->timers, current_info->attack_frames * current_info->attack_duration, TIMER_ENEMY_ANIMATION, i);
         }
     }
+    memcpy(enemies->last_position, enemies->position, sizeof(vector) * enemies->store.count);
+    entity_integrate(enemies->position, enemies->step, enemies->store.count);
+    for(int i = 0; i < enemies->store.count; i++){
 
-    // Projectile movement
-    // We go last to first element so that deletion logic is cleaner
-    for(int i = state->projectile_count - 1; i >= 0; i--){
+        spatial_hash_move(state->enemy_hash, enemies->hash_entry[i], enemies->position[i]);
+    }
+    for(int i = 0; i < enemies->store.count; i++){
+
+        enemy_resolve_collisions(state, i, delta);
+    }
 
-        if(state->projectiles[i].velocity.x != 0 || state->projectiles[i].velocity.y != 0){
+    state_remove_queued(state);
+    state->tick++;
+}
 
-            // Move projectile
-            state->projectiles[i].position = vector_sum(state->projectiles[i].position, state->projectiles[i].velocity);
+void state_handle_timers(State* state){
 
-            // Check wall collisions
-            if(in_wall(state, state->projectiles[i].position)){
+    // A timer can be cancelled by one handled before it, in which case its owner won't be holding it any more
+    timer_wheel* timers = state->timers;
+    for(int i = 0; i < timers->fired_count; i++){
 
-                vector_array_delete(state->projectiles, i, &state->projectile_count, sizeof(projectile));
-                continue;
-            }
+        int timer = timers->fired[i].timer;
+        int kind = timers->fired[i].kind;
+        int owner = timers->fired[i].owner;
+        if(kind == TIMER_PLAYER_KNOCKBACK && state->player_knockback_timer == timer){
 
-            // Check enemy collisions
-            for(int j = 0; j < state->enemy_count; j++){
+            state->player_knockback_timer = -1;
+            state->player_velocity = ZERO_VECTOR;
 
-                if(vector_distance(state->projectiles[i].position, state->enemies[j].position) <= 0.2){
+        }else if(kind == TIMER_PLAYER_SPELLCAST && state->player_animation_timer == timer){
 
-                    enemy_injure(&(state->enemies[j]), 1, ZERO_VECTOR, 10.0);
-                    vector_array_delete(state->projectiles, i, &state->projectile_count, sizeof(projectile));
-                    continue;
-                }
-            }
+            state->player_animation_timer = -1;
+            state->player_animation_state = PLAYER_ANIMATION_STATE_IDLE;
+            state->player_animation_start = timers->now;
+            player_cast_finish(state);
+
+        }else if(kind == TIMER_ENEMY_ANIMATION && state->enemies.animation_timer[owner] == timer){
+
+            state->enemies.animation_timer[owner] = -1;
+            state->enemies.state[owner] = ENEMY_STATE_IDLE;
+            state->enemies.velocity[owner] = ZERO_VECTOR;
         }
     }
+}
 
-    // Enemy update
-    for(int i = state->enemy_count - 1; i >= 0; i--){
+void state_remove_queued(State* state){
+
+    int index;
+    while((index = entity_store_pop_removal(&state->projectiles.store)) != -1){
 
-        enemy_update(state, i, delta);
+        entity_store_swap_remove(&state->projectiles.store, index);
+    }
+
+    enemy_list* enemies = &state->enemies;
+    while((index = entity_store_pop_removal(&enemies->store)) != -1){
+
+        if(enemies->path_job[index] != NULL){
+
+            path_queue_cancel(state->path_queue, enemies->path_job[index]);
+        }
+        enemy_cancel_timer(state, index);
+        spatial_hash_remove(state->enemy_hash, enemies->hash_entry[index]);
+        enemy_list_swap_remove(enemies, index);
+
+        // The last enemy was moved into the removed one's place
+        if(index < enemies->store.count){
+
+            spatial_hash_set_owner(state->enemy_hash, enemies->hash_entry[index], index);
+            if(enemies->animation_timer[index] != -1){
+
+                timer_wheel_set_owner(state->timers, enemies->animation_timer[index], index);
+            }
+        }
     }
 }
 
-void enemy_update(State* state, int index, float delta){
+enemy_tier enemy_choose_tier(State* state, int index){
 
-    enemy* current_enemy = &state->enemies[index];
-    enemy_data* current_info = &(enemy_info[state->enemies[index].name]);
+    float distance = vector_distance(state->enemies.position[index], state->player_position);
+    bool in_sight = state->enemies.sees_player[index];
 
-    if(current_enemy->health <= 0){
+    if(distance <= ENEMY_TIER_NEAR_DISTANCE || (in_sight && distance <= ENEMY_TIER_NEAR_DISTANCE * 2)){
 
-        vector_array_delete(state->enemies, index, &state->enemy_count, sizeof(enemy));
-        return;
+        return ENEMY_TIER_NEAR;
+
+    }else if(in_sight || distance <= ENEMY_TIER_NEAR_DISTANCE * 2){
+
+        return ENEMY_TIER_MID;
+
+    }else if(distance <= ENEMY_TIER_SIGHT_DISTANCE){
+
+        return ENEMY_TIER_FAR;
     }
 
-    // Movement
-    vector enemy_last_pos = current_enemy->position;
+    return ENEMY_TIER_DORMANT;
+}
+
+bool enemy_is_due(State* state, int index){
 
-    if(current_enemy->state != ENEMY_STATE_ATTACKING && current_enemy->state != ENEMY_STATE_KNOCKBACK && vector_distance(state->player_position, current_enemy->position) <= current_info->attack_radius){
+    // Offsetting by the enemy's slot spreads each tier's enemies evenly over the ticks it skips
+    int slot = state->enemies.store.slots[index];
+    return (state->tick + slot) % ENEMY_TIER_PERIODS[state->enemies.tier[index]] == 0;
+}
+
+void enemy_update(State* state, int index, float delta){
 
-        if(state->enemies[index].state != ENEMY_STATE_ATTACKING){
+    enemy_list* enemies = &state->enemies;
+    enemy_data* current_info = &(enemy_info[enemies->name[index]]);
 
-            current_enemy->state = ENEMY_STATE_ATTACKING;
-            current_enemy->velocity = ZERO_VECTOR;
-        }
+    // Catch up on the ticks skipped since the last update
+    int elapsed_ticks = state->tick - enemies->last_update_tick[index];
+    if(elapsed_ticks < 1){
+
+        elapsed_ticks = 1;
+
+    }else if(elapsed_ticks > ENEMY_TIER_PERIODS[NUM_ENEMY_TIERS - 1]){
+
+        elapsed_ticks = ENEMY_TIER_PERIODS[NUM_ENEMY_TIERS - 1];
     }
+    enemies->last_update_tick[index] = state->tick;
 
-    if(current_enemy->state == ENEMY_STATE_KNOCKBACK){
+    enemies->tier[index] = enemy_choose_tier(state, index);
 
-        current_enemy->animation_timer -= delta;
-        if(current_enemy->animation_timer <= 0){
+    // Dead enemies are removed at the end of the tick
+    if(enemies->health[index] <= 0){
 
-            current_enemy->state = ENEMY_STATE_IDLE;
-            current_enemy->animation_timer = 0;
-            current_enemy->velocity = ZERO_VECTOR;
-        }
+        enemies->velocity[index] = ZERO_VECTOR;
+        enemies->step[index] = ZERO_VECTOR;
+        return;
+    }
+
+    // Movement, enemies only go after a player they can see
+    if(enemies->state[index] != ENEMY_STATE_ATTACKING && enemies->state[index] != ENEMY_STATE_KNOCKBACK && enemies->sees_player[index] && vector_distance(state->player_position, enemies->position[index]) <= current_info->attack_radius){
 
-    }else if(current_enemy->state == ENEMY_STATE_ATTACKING){
+        enemies->state[index] = ENEMY_STATE_ATTACKING;
+        enemies->animation_start[index] = state->timers->now;
+        enemies->velocity[index] = ZERO_VECTOR;
+    }
+
+    // Knocked back enemies keep going the way they were pushed until the knockback's timer fires
+    if(enemies->state[index] == ENEMY_STATE_ATTACKING){
 
-        if(enemy_has_hurtbox(current_enemy)){
+        if(enemy_has_hurtbox(enemies, index, state->timers->now)){
 
-            if(current_enemy->velocity.x == 0 && current_enemy->velocity.y == 0){
+            if(enemies->velocity[index].x == 0 && enemies->velocity[index].y == 0){
 
-                current_enemy->velocity = vector_scale(vector_sub(state->player_position, current_enemy->position), current_info->attack_speed);
+                enemies->velocity[index] = vector_scale(vector_sub(state->player_position, enemies->position[index]), current_info->attack_speed);
             }
 
         }else{
 
-            current_enemy->velocity = ZERO_VECTOR;
+            enemies->velocity[index] = ZERO_VECTOR;
         }
 
-    }else{
+    }else if(enemies->state[index] != ENEMY_STATE_KNOCKBACK && !enemies->sees_player[index]){
 
-        vector enemy_target;
-        bool success = map_pathfind(state->map, current_enemy->position, state->player_position, &enemy_target);
-        if(success){
+        // An enemy that's lost the player has no use for the path it was waiting on
+        enemies->state[index] = ENEMY_STATE_IDLE;
+        enemies->velocity[index] = ZERO_VECTOR;
+        if(enemies->path_job[index] != NULL){
 
-            current_enemy->state = ENEMY_STATE_MOVING;
+            enemies->path_cancelled[index] = enemies->path_job[index];
+            enemies->path_job[index] = NULL;
+        }
 
+    }else if(enemies->state[index] != ENEMY_STATE_KNOCKBACK){
+
+        // While a new path is being searched for, the enemy keeps doing whatever it was doing before
+        pathfind_status path_status = enemy_update_path(state, index);
+        if(path_status == PATHFIND_FOUND){
+
+            if(enemies->state[index] != ENEMY_STATE_MOVING){
+
+                enemies->state[index] = ENEMY_STATE_MOVING;
+                enemies->animation_start[index] = state->timers->now;
+            }
+
+            // Head for the next square along the path, or the last one if the enemy is already at the end of it
+            path* the_path = &enemies->path[index];
+            int target_index = enemies->path_index[index] + 1 < the_path->length ? enemies->path_index[index] + 1 : enemies->path_index[index];
+            vector enemy_target = the_path->squares[target_index];
             enemy_target.x += 0.5;
             enemy_target.y += 0.5;
-            vector enemy_direction = vector_scale(vector_sub(enemy_target, current_enemy->position), 1);
+            vector enemy_direction = vector_scale(vector_sub(enemy_target, enemies->position[index]), 1);
 
-            current_enemy->velocity = vector_scale(enemy_direction, current_info->speed);
+            enemies->velocity[index] = vector_scale(enemy_direction, current_info->speed);
 
-        }else{
+        }else if(path_status == PATHFIND_FAILED){
 
-            current_enemy->state = ENEMY_STATE_IDLE;
-            current_enemy->velocity = ZERO_VECTOR;
+            enemies->state[index] = ENEMY_STATE_IDLE;
+            enemies->velocity[index] = ZERO_VECTOR;
         }
     }
 
-    current_enemy->position = vector_sum(current_enemy->position, current_enemy->velocity);
-    check_rect_wall_collisions(state, &(current_enemy->position), enemy_last_pos, current_enemy->velocity, 0.5);
+    enemies->step[index] = vector_mult(enemies->velocity[index], elapsed_ticks);
+}
+
+void enemy_resolve_collisions(State* state, int index, float delta){
+
+    // Enemies that weren't updated this tick didn't move
+    enemy_list* enemies = &state->enemies;
+    if(enemies->health[index] <= 0 || enemies->last_update_tick[index] != state->tick){
+
+        return;
+    }
+
+    vector* enemy_position = &enemies->position[index];
+    vector enemy_last_pos = enemies->last_position[index];
+    vector enemy_step = enemies->step[index];
+    check_rect_wall_collisions(state, enemy_position, enemy_last_pos, enemy_step, 0.5);
 
     // Check for collisions with other enemies
-    for(int j = 0; j < state->enemy_count; j++){
+    int nearby_count = spatial_hash_query_radius(state->enemy_hash, *enemy_position, 0.5 + vector_magnitude(enemy_step));
+    for(int i = 0; i < nearby_count; i++){
 
-        if(index == j){
+        int other = state->enemy_hash->results[i];
+        if(index == other){
 
             continue;
         }
 
-        check_sprite_collision(&(current_enemy->position), enemy_last_pos, current_enemy->velocity, state->enemies[j].position, 0.5);
+        check_sprite_collision(enemy_position, enemy_last_pos, enemy_step, enemies->position[other], 0.5);
     }
+    spatial_hash_move(state->enemy_hash, enemies->hash_entry[index], *enemy_position);
 
     // After checking for collisions, check if hurt player
-    if(enemy_has_hurtbox(current_enemy) && vector_distance(current_enemy->position, state->player_position) <= 0.2){
+    if(enemy_has_hurtbox(enemies, index, state->timers->now) && vector_distance(*enemy_position, state->player_position) <= 0.2){
 
-        player_knockback(state, current_enemy->velocity);
-        current_enemy->state = ENEMY_STATE_IDLE;
-        current_enemy->velocity = ZERO_VECTOR;
+        player_knockback(state, enemies->velocity[index]);
+        enemy_cancel_timer(state, index);
+        enemies->state[index] = ENEMY_STATE_IDLE;
+        enemies->velocity[index] = ZERO_VECTOR;
     }
+}
+
+void enemy_injure(State* state, int index, int damage, vector knockback, float knockback_duration){
 
-    // Animation
-    enemy_animation_update(current_enemy, delta);
+    enemy_list* enemies = &state->enemies;
+    enemies->health[index] -= damage;
+    if(knockback_duration != 0){
+
+        enemy_cancel_timer(state, index);
+        enemies->state[index] = ENEMY_STATE_KNOCKBACK;
+        enemies->velocity[index] = knockback;
+        enemies->animation_start[index] = state->timers->now;
+        enemies->animation_timer[index] = timer_wheel_schedule(state->timers, knockback_duration, TIMER_ENEMY_ANIMATION, index);
+    }
+}
+
+// The enemy will have moved since the path was asked for, so enemy_update_path() starts it from wherever it is on it now
+void enemy_collect_path(State* state, int index){
+
+    enemy_list* enemies = &state->enemies;
+    if(enemies->path_job[index] == NULL){
+
+        return;
+    }
+
+    int revision;
+    pathfind_status job_status = path_queue_collect(state->path_queue, enemies->path_job[index], &enemies->path[index], &revision);
+    if(job_status != PATHFIND_SEARCHING){
+
+        enemies->path_job[index] = NULL;
+        enemies->path_index[index] = 0;
+        enemies->path_revision[index] = revision;
+        if(job_status == PATHFIND_FAILED){
+
+            enemies->path[index].length = 0;
+        }
+    }
+}
+
+pathfind_status enemy_update_path(State* state, int index){
+
+    enemy_list* enemies = &state->enemies;
+    map* the_map = state->map;
+    path* the_path = &enemies->path[index];
+    vector enemy_square = (vector){ .x = (int)enemies->position[index].x, .y = (int)enemies->position[index].y };
+    vector goal_square = (vector){ .x = (int)state->player_position.x, .y = (int)state->player_position.y };
+
+    // If the player can't be reached there's nothing to search for, so the enemy just waits until they can be
+    if(!map_squares_connected(the_map, enemy_square, goal_square)){
+
+        if(enemies->path_job[index] != NULL){
+
+            enemies->path_cancelled[index] = enemies->path_job[index];
+            enemies->path_job[index] = NULL;
+        }
+        the_path->length = 0;
+        return PATHFIND_FAILED;
+    }
+
+    // If the collidemap changed since the path was found, the path only needs to go if a square still ahead on it got blocked
+    bool path_valid = the_path->length != 0;
+    if(path_valid && enemies->path_revision[index] != the_map->collide_revision){
+
+        for(int i = enemies->path_index[index]; i < the_path->length; i++){
+
+            if(map_square_occupied(the_map, the_path->squares[i])){
+
+                path_valid = false;
+                break;
+            }
+        }
+        enemies->path_revision[index] = the_map->collide_revision;
+    }
+
+    // Follow the enemy along the path, if it's been pushed off of it then the path is no good anymore
+    if(path_valid){
+
+        int path_index = path_find_square(the_path, enemy_square, enemies->path_index[index]);
+        if(path_index == -1){
+
+            path_valid = false;
+
+        }else{
+
+            enemies->path_index[index] = path_index;
+        }
+    }
+    if(!path_valid){
+
+        the_path->length = 0;
+    }
+
+    vector path_goal = path_valid ? the_path->squares[the_path->length - 1] : ZERO_VECTOR;
+    if(path_valid && path_goal.x == goal_square.x && path_goal.y == goal_square.y){
+
+        return PATHFIND_FOUND;
+    }
+
+    // The player has moved on since the pending search was asked for, so ask again
+    if(enemies->path_job[index] != NULL){
+
+        path_job* job = enemies->path_job[index];
+        if(job->goal != (int)goal_square.x + ((int)goal_square.y * the_map->width)){
+
+            enemies->path_cancelled[index] = job;
+            enemies->path_job[index] = NULL;
+        }
+    }
+
+    // Asking from the start of the old path lets the queue resume the search that found it against the new goal,
+    // the enemy has walked along the old path since so it will still be on the new one most of the time
+    // The request itself is made by state_update() once every enemy has been updated, after the old job's cancelled
+    if(enemies->path_job[index] == NULL){
+
+        enemies->path_requested[index] = true;
+        enemies->path_request_start[index] = path_valid ? the_path->squares[0] : enemy_square;
+    }
+
+    // Keep following the old path until the new one turns up
+    return path_valid ? PATHFIND_FOUND : PATHFIND_SEARCHING;
 }
 
 // Collision helpers / handlers
@@ -339,43 +724,16 @@ bool rect_in_wall(State* state, vector rect_pos, vector rect_dim){
     return is_in_wall;
 }
 
-void check_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity){
-
-    if(in_wall(state, *mover_position)){
+bool check_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity){
 
-        bool x_caused = in_wall(state, vector_sum(mover_last_pos, (vector){ .x = velocity.x, .y = 0 }));
-        bool y_caused = in_wall(state, vector_sum(mover_last_pos, (vector){ .x = 0, .y = velocity.y }));
-
-        if(x_caused){
-
-            mover_position->x = mover_last_pos.x;
-        }
-        if(y_caused){
-
-            mover_position->y = mover_last_pos.y;
-        }
-    }
+    *mover_position = mover_last_pos;
+    return sweep_slide(state->map, mover_position, 0, velocity);
 }
 
-void check_rect_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity, float rect_size){
-
-    vector rect_pos = (vector){ .x = mover_position->x - (rect_size / 2), .y = mover_position->y - (rect_size / 2) };
-    vector rect_last_pos = (vector){ .x = mover_last_pos.x - (rect_size / 2), .y = mover_last_pos.y - (rect_size / 2) };
-    vector rect_dim = (vector){ .x = rect_size, .y = rect_size };
-    if(rect_in_wall(state, rect_pos, rect_dim)){
-
-        bool x_caused = rect_in_wall(state, vector_sum(rect_last_pos, (vector){ .x = velocity.x, .y = 0 }), rect_dim);
-        bool y_caused = rect_in_wall(state, vector_sum(rect_last_pos, (vector){ .x = 0, .y = velocity.y }), rect_dim);
-
-        if(x_caused){
-
-            mover_position->x = mover_last_pos.x;
-        }
-        if(y_caused){
+bool check_rect_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity, float rect_size){
 
-            mover_position->y = mover_last_pos.y;
-        }
-    }
+    *mover_position = mover_last_pos;
+    return sweep_slide(state->map, mover_position, rect_size, velocity);
 }
 
 void check_sprite_collision(vector* mover_position, vector mover_last_pos, vector velocity, vector object, float collision_dist){
@@ -398,6 +756,17 @@ void check_sprite_collision(vector* mover_position, vector mover_last_pos, vecto
 
 // Player
 
+int player_get_animation_frame(State* state){
+
+    if(state->player_animation_state != PLAYER_ANIMATION_STATE_SPELLCAST){
+
+        return 0;
+    }
+
+    int frame = (int)((state->timers->now - state->player_animation_start) / PLAYER_ANIMATION_SPELLCAST_DURATION);
+    return frame < PLAYER_ANIMATION_SPELLCAST_FRAMES ? frame : PLAYER_ANIMATION_SPELLCAST_FRAMES - 1;
+}
+
 vector player_get_animation_offset(State* state){
 
     if(state->player_animation_state == PLAYER_ANIMATION_STATE_SPELLCAST){
@@ -407,10 +776,11 @@ vector player_get_animation_offset(State* state){
     }else{
 
         vector offset;
+        float walk_time = state->player_animation_state == PLAYER_ANIMATION_STATE_WALK ? fmod(state->timers->now - state->player_animation_start, PLAYER_ANIMATION_WALK_DURATION) : 0;
 
         // compute x offset
         float half_time = PLAYER_ANIMATION_WALK_DURATION / 2;
-        float fmod_time = state->player_animation_timer;
+        float fmod_time = walk_time;
         bool second_half = false;
         if(fmod_time > half_time){
 
@@ -423,7 +793,7 @@ vector player_get_animation_offset(State* state){
 
         // compute y offset
         float quarter_time = PLAYER_ANIMATION_WALK_DURATION / 4;
-        fmod_time = state->player_animation_timer;
+        fmod_time = walk_time;
         int which_quarter = 0;
         while(fmod_time > quarter_time){
 
@@ -442,12 +812,20 @@ void player_knockback(State* state, vector impact_vector){
 
     // Knockback player
     state->player_velocity = impact_vector;
-    state->player_knockback_timer = 20.0;
+    if(state->player_knockback_timer != -1){
+
+        timer_wheel_cancel(state->timers, state->player_knockback_timer);
+    }
+    state->player_knockback_timer = timer_wheel_schedule(state->timers, 20.0, TIMER_PLAYER_KNOCKBACK, -1);
 
     // Reset animation / interrupt current spellcast
+    if(state->player_animation_timer != -1){
+
+        timer_wheel_cancel(state->timers, state->player_animation_timer);
+        state->player_animation_timer = -1;
+    }
     state->player_animation_state = PLAYER_ANIMATION_STATE_IDLE;
-    state->player_animation_frame = 0;
-    state->player_animation_timer = 0;
+    state->player_animation_start = state->timers->now;
 }
 
 bool player_is_spellcasting(State* state){
@@ -459,8 +837,12 @@ void player_cast_start(State* state, int spell_index){
 
     state->player_spell_selection = spell_index;
     state->player_animation_state = PLAYER_ANIMATION_STATE_SPELLCAST;
-    state->player_animation_frame = 0;
-    state->player_animation_timer = 0;
+    state->player_animation_start = state->timers->now;
+    if(state->player_animation_timer != -1){
+
+        timer_wheel_cancel(state->timers, state->player_animation_timer);
+    }
+    state->player_animation_timer = timer_wheel_schedule(state->timers, PLAYER_ANIMATION_SPELLCAST_DURATION * PLAYER_ANIMATION_SPELLCAST_FRAMES, TIMER_PLAYER_SPELLCAST, -1);
 }
 
 void player_cast_finish(State* state){
@@ -477,35 +859,22 @@ void player_cast_finish(State* state){
 
 void player_cast_bolt(State* state){
 
-    projectile to_add = (projectile){
-        .image = 0,
-        .position = vector_sum(state->player_position, vector_scale(state->player_direction, 0.2)),
-        .velocity = vector_scale(state->player_direction, 0.1)
-    };
-    vector_array_push((void**)&(state->projectiles), &to_add, &(state->projectile_count), &(state->projectile_capacity), sizeof(projectile));
+    // Out of projectiles, the spell fizzles
+    projectile_list_add(&state->projectiles, 0, vector_sum(state->player_position, vector_scale(state->player_direction, 0.2)), vector_scale(state->player_direction, 0.1));
 }
 
 void player_cast_kinetic(State* state){
 
-    vector player_look_point = vector_sum(state->player_position, state->player_direction);
-    float player_angle = atan2(player_look_point.y - state->player_position.y, player_look_point.x - state->player_position.x) * (180 / PI);
-
-    for(int i = 0; i < state->enemy_count; i++){
-
-        enemy* current_enemy = &(state->enemies[i]);
-
-        if(vector_distance(current_enemy->position, state->player_position) > 2.5){
-
-            continue;
-        }
-
-        vector difference_vector = (vector){ .x = current_enemy->position.x - state->player_position.x, .y = current_enemy->position.y - state->player_position.y };
-        float angle = (atan2(difference_vector.y, difference_vector.x) * (180 / PI));
-        if(fabs(player_angle - angle) <= 50.0){
+    int hit_count = spatial_hash_query_cone(state->enemy_hash, state->player_position, state->player_direction, 2.5, 50.0);
+    for(int i = 0; i < hit_count; i++){
 
-            enemy_injure(current_enemy, 0, vector_scale(difference_vector, 0.1), 20.0);
-        }
+        int index = state->enemy_hash->results[i];
+        vector difference_vector = vector_sub(state->enemies.position[index], state->player_position);
+        enemy_injure(state, index, 0, vector_scale(difference_vector, 0.1), 20.0);
     }
+
+    vector origin = vector_sum(state->player_position, vector_scale(state->player_direction, 0.3));
+    particle_burst(&state->particles, PARTICLE_KINETIC, origin, -0.1, vector_scale(state->player_direction, 0.06), 0.02, KINETIC_PARTICLES, 40.0);
 }
 
 // Raycasting
@@ -638,7 +1007,7 @@ bool ray_intersects(State* state, vector origin, vector ray, vector target){
     return target_distance <= wall_distance;
 }
 
-void render_raycast(State* state, vector origin, vector ray, float* wall_dist, int* texture_x, bool* x_sided, int* texture){
+void render_raycast(State* state, vector origin, vector ray, int texture_size, float* wall_dist, int* texture_x, bool* x_sided, int* texture){
 
     vector current = origin;
 
@@ -700,11 +1069,16 @@ void render_raycast(State* state, vector origin, vector ray, float* wall_dist, i
     } // End while
 
     *texture = wall_hit;
-    *x_sided = current.x == (int)current.x;
+    render_raycast_hit(origin, ray, current, texture_size, wall_dist, texture_x, x_sided);
+}
+
+void render_raycast_hit(vector origin, vector ray, vector hit, int texture_size, float* wall_dist, int* texture_x, bool* x_sided){
+
+    *x_sided = hit.x == (int)hit.x;
 
-    vector dist = (vector){ .x = current.x - origin.x, .y = current.y - origin.y };
+    vector dist = (vector){ .x = hit.x - origin.x, .y = hit.y - origin.y };
     *wall_dist = *x_sided ? dist.x / ray.x : dist.y / ray.y;
 
-    int wall_x = (int)((*x_sided ? current.y - (int)current.y : current.x - (int)current.x) * 64.0);
-    *texture_x = (*x_sided && ray.x > 0) || (!*x_sided && ray.y < 0) ? 64 - wall_x - 1 : wall_x;
+    int wall_x = (int)((*x_sided ? hit.y - (int)hit.y : hit.x - (int)hit.x) * texture_size);
+    *texture_x = (*x_sided && ray.x > 0) || (!*x_sided && ray.y < 0) ? texture_size - wall_x - 1 : wall_x;
 }
@@ -3,6 +3,12 @@
 #include "vector.h"
 #include "map.h"
 #include "enemy.h"
+#include "spatial_hash.h"
+#include "worker_pool.h"
+#include "timer_wheel.h"
+#include "line_of_sight.h"
+#include "sweep.h"
+#include "particles.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -22,12 +28,12 @@ typedef struct animation{
     float timer;
 } animation;
 
-typedef struct projectile{
-
-    int image;
-    vector position;
-    vector velocity;
-} projectile;
+// What a timer on the state's timer wheel ends when it fires, the owner is an enemy index or -1 for the player
+typedef enum timer_kind{
+    TIMER_PLAYER_KNOCKBACK,
+    TIMER_PLAYER_SPELLCAST,
+    TIMER_ENEMY_ANIMATION // the enemy's attack or knockback
+} timer_kind;
 
 typedef struct State{
 
@@ -38,27 +44,34 @@ typedef struct State{
     vector player_camera;
     float player_rotate_dir;
 
-    float player_knockback_timer;
+    int player_knockback_timer; // timer that ends the knockback, -1 while the player isn't being knocked back
 
     int player_spell_selection;
 
     int player_animation_state;
-    int player_animation_frame;
-    float player_animation_timer;
+    int player_animation_start; // when the animation began on the timer wheel
+    int player_animation_timer; // timer that ends the spellcast, -1 if there isn't one
+
+    int tick; // ticks since the state was made
+    timer_wheel* timers;
+    float timer_remainder; // delta that hasn't added up to a whole unit of timer wheel time yet
 
     map* map;
+    path_queue* path_queue;
+    line_of_sight* sight;
+    worker_pool* workers;
 
     sprite* objects;
     int object_count;
     int object_capacity;
+    spatial_hash* object_hash; // objects never move, so they're binned once when the state is made
 
-    projectile* projectiles;
-    int projectile_count;
-    int projectile_capacity;
+    projectile_list projectiles;
+    particle_list particles;
 
-    enemy* enemies;
-    int enemy_count;
-    int enemy_capacity;
+    enemy_list enemies;
+    spatial_hash* enemy_hash; // owners are indices into enemies
+    int enemy_tier_counts[NUM_ENEMY_TIERS]; // how many enemies were in each tier this tick
 } State;
 
 // Init
@@ -66,16 +79,25 @@ State* state_init();
 
 // Updates
 void state_update(State* state, float delta);
-void enemy_update(State* state, int index, float delta);
+void state_handle_timers(State* state); // carries out whatever the timers that fired this tick were waiting to do
+void enemy_update(State* state, int index, float delta); // decides where the enemy is going this tick, it's moved afterwards along with the others. Only writes to the enemy itself, so enemies can be updated in parallel
+enemy_tier enemy_choose_tier(State* state, int index); // decides how often the enemy should be updated from where it is relative to the player
+bool enemy_is_due(State* state, int index); // returns true if the enemy's tier has it updating this tick
+void enemy_resolve_collisions(State* state, int index, float delta); // pushes the enemy back out of anything it moved into and finishes its update
+void state_remove_queued(State* state); // carries out the removals queued during the tick
+void enemy_injure(State* state, int index, int damage, vector knockback, float knockback_duration);
+void enemy_collect_path(State* state, int index); // picks up the enemy's path if the queue has finished searching for it, called in enemy order before the enemies are updated
+pathfind_status enemy_update_path(State* state, int index); // keeps the enemy's cached path leading to the player, returns PATHFIND_SEARCHING while a new one is being searched for and PATHFIND_FAILED if there is no path. Jobs it's done with are left in path_cancelled and new ones asked for with path_requested, so it never touches the queue itself
 
 // Collision helpers / handlers
 bool in_wall(State* state, vector v); // returns true if the position given by the vector is in a wall on the map
 bool rect_in_wall(State* state, vector rect_pos, vector rect_dim); // returns true if the given rectangle intersects with a wall on the map
-void check_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity); // checks for wall collisions for a given "mover" that has moved this frame. if there is a collision, movement will be rewinded along the axis where collision occurred
-void check_rect_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity, float rect_size);
+bool check_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity); // sweeps a "mover" that has moved this frame along its move from its last position, stopping it at the first wall and sliding it along it. returns true if it hit a wall
+bool check_rect_wall_collisions(State* state, vector* mover_position, vector mover_last_pos, vector velocity, float rect_size);
 void check_sprite_collision(vector* mover_position, vector mover_last_pos, vector velocity, vector object, float collision_dist);
 
 // Player
+int player_get_animation_frame(State* state);
 vector player_get_animation_offset(State* state); // returns the offset of the player animation, used to create the head bobbing effect when walking
 void player_knockback(State* state, vector impact_vector); // knocks back the player with the force of the impact vector
 bool player_is_spellcasting(State* state);
@@ -88,4 +110,5 @@ void player_cast_kinetic(State* state); // causes player to cast the "kinetic" s
 int hits_wall(State* state, vector v); // returns true if point touches a wall on the map
 bool hit_tile(vector v, vector tile); // returns true if point touches an edge of a given tile
 bool ray_intersects(State* state, vector origin, vector ray, vector target); // casts a ray and returns true if it intersects with the target vector
-void render_raycast(State* state, vector origin, vector ray, float* wall_dist, int* texture_x, bool* x_sided, int* texture); // casts a ray and returns info needed for rendering
+void render_raycast(State* state, vector origin, vector ray, int texture_size, float* wall_dist, int* texture_x, bool* x_sided, int* texture); // casts a ray and returns info needed for rendering, texture_x is in texels of a texture_size wide texture
+void render_raycast_hit(vector origin, vector ray, vector hit, int texture_size, float* wall_dist, int* texture_x, bool* x_sided); // the rendering info for where a ray from origin hit a wall
@@ -0,0 +1,193 @@
+#include "sweep.h"
+
+#include <math.h>
+
+// Sliding constants
+const float SWEEP_SKIN = 0.001; // how far from a wall a mover is left, so that sliding along it doesn't catch on the squares it's touching
+const int SWEEP_SLIDE_STEPS = 3; // a move can be redirected by at most this many walls
+
+static const sweep_hit NO_HIT = { .hit = false, .time = 1, .normal = { .x = 0, .y = 0 } };
+
+static bool is_solid(map* the_map, int x, int y){
+
+    if(x < 0 || y < 0 || x >= the_map->width || y >= the_map->height){
+
+        return true;
+    }
+    return the_map->wall[x + (y * the_map->width)] != 0;
+}
+
+sweep_hit sweep_segment(map* the_map, vector start, vector move){
+
+    int x = (int)floor(start.x);
+    int y = (int)floor(start.y);
+    int step_x = move.x > 0 ? 1 : -1;
+    int step_y = move.y > 0 ? 1 : -1;
+
+    // How far through the move the next square edge along each axis is, and how far it is between edges
+    float next_x = INFINITY;
+    float next_y = INFINITY;
+    float delta_x = INFINITY;
+    float delta_y = INFINITY;
+    if(move.x != 0){
+
+        next_x = (move.x > 0 ? x + 1 - start.x : start.x - x) / fabs(move.x);
+        delta_x = 1 / fabs(move.x);
+    }
+    if(move.y != 0){
+
+        next_y = (move.y > 0 ? y + 1 - start.y : start.y - y) / fabs(move.y);
+        delta_y = 1 / fabs(move.y);
+    }
+
+    while(true){
+
+        sweep_hit contact;
+        if(next_x < next_y){
+
+            if(next_x > 1){
+
+                return NO_HIT;
+            }
+            x += step_x;
+            contact = (sweep_hit){ .hit = true, .time = next_x, .normal = { .x = -step_x, .y = 0 } };
+            next_x += delta_x;
+
+        }else{
+
+            if(next_y > 1){
+
+                return NO_HIT;
+            }
+            y += step_y;
+            contact = (sweep_hit){ .hit = true, .time = next_y, .normal = { .x = 0, .y = -step_y } };
+            next_y += delta_y;
+        }
+
+        if(is_solid(the_map, x, y)){
+
+            return contact;
+        }
+    }
+}
+
+// Finds when a moving interval first overlaps another one, as a range of times through the move
+static bool axis_overlap(float position, float half_size, float move, float low, float high, float* entry, float* exit){
+
+    if(move == 0){
+
+        *entry = -INFINITY;
+        *exit = INFINITY;
+        return position + half_size > low && position - half_size < high;
+    }
+
+    float first = (low - half_size - position) / move;
+    float second = (high + half_size - position) / move;
+    *entry = first < second ? first : second;
+    *exit = first < second ? second : first;
+    return true;
+}
+
+sweep_hit sweep_box(map* the_map, vector center, float size, vector move){
+
+    float half_size = size / 2;
+    int low_x = (int)floor(fmin(center.x, center.x + move.x) - half_size);
+    int high_x = (int)floor(fmax(center.x, center.x + move.x) + half_size);
+    int low_y = (int)floor(fmin(center.y, center.y + move.y) - half_size);
+    int high_y = (int)floor(fmax(center.y, center.y + move.y) + half_size);
+
+    sweep_hit first = NO_HIT;
+    for(int y = low_y; y <= high_y; y++){
+
+        for(int x = low_x; x <= high_x; x++){
+
+            if(!is_solid(the_map, x, y)){
+
+                continue;
+            }
+
+            float entry_x, exit_x, entry_y, exit_y;
+            if(!axis_overlap(center.x, half_size, move.x, x, x + 1, &entry_x, &exit_x) || !axis_overlap(center.y, half_size, move.y, y, y + 1, &entry_y, &exit_y)){
+
+                continue;
+            }
+
+            // Already overlapping at the start counts as missing, as does touching only after the move
+            float entry = fmax(entry_x, entry_y);
+            float exit = fmin(exit_x, exit_y);
+            if(entry >= exit || entry < 0 || entry > 1 || (first.hit && entry >= first.time)){
+
+                continue;
+            }
+
+            first.hit = true;
+            first.time = entry;
+            if(entry_x >= entry_y){
+
+                first.normal = (vector){ .x = move.x > 0 ? -1 : 1, .y = 0 };
+
+            }else{
+
+                first.normal = (vector){ .x = 0, .y = move.y > 0 ? -1 : 1 };
+            }
+        }
+    }
+
+    return first;
+}
+
+bool sweep_slide(map* the_map, vector* center, float size, vector move){
+
+    bool hit_any = false;
+    for(int i = 0; i < SWEEP_SLIDE_STEPS; i++){
+
+        if(move.x == 0 && move.y == 0){
+
+            return hit_any;
+        }
+
+        sweep_hit contact = size == 0 ? sweep_segment(the_map, *center, move) : sweep_box(the_map, *center, size, move);
+        if(!contact.hit){
+
+            *center = vector_sum(*center, move);
+            return hit_any;
+        }
+        hit_any = true;
+
+        // Stop just short of the wall, then carry on with whatever is left of the move that runs along it
+        *center = vector_sum(*center, vector_mult(move, contact.time));
+        *center = vector_sum(*center, vector_mult(contact.normal, SWEEP_SKIN));
+        move = vector_mult(move, 1 - contact.time);
+        if(contact.normal.x != 0){
+
+            move.x = 0;
+
+        }else{
+
+            move.y = 0;
+        }
+    }
+
+    return hit_any;
+}
+
+float sweep_circle(vector start, vector move, vector center, float radius){
+
+    vector offset = vector_sub(start, center);
+    float c = (offset.x * offset.x) + (offset.y * offset.y) - (radius * radius);
+    if(c <= 0){
+
+        return 0;
+    }
+
+    float a = (move.x * move.x) + (move.y * move.y);
+    float b = 2 * ((move.x * offset.x) + (move.y * offset.y));
+    float discriminant = (b * b) - (4 * a * c);
+    if(a == 0 || discriminant < 0){
+
+        return -1;
+    }
+
+    float time = (-b - sqrt(discriminant)) / (2 * a);
+    return time >= 0 && time <= 1 ? time : -1;
+}
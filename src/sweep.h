@@ -0,0 +1,26 @@
+#pragma once
+
+#include "vector.h"
+#include "map.h"
+
+#include <stdbool.h>
+
+/*
+ * Continuous collision against the walls of the map grid
+ *
+ * Rather than checking where something ends up, these follow its whole move and find the first wall it touches on the
+ * way, so nothing can pass through a wall or clip a corner however fast it's going. A segment (a point moving) steps
+ * through the squares it crosses one at a time, a box checks every wall square its move could reach. Squares off the
+ * edge of the map count as walls, and a wall the mover already overlaps at the start is ignored so it can get back out
+ */
+
+typedef struct sweep_hit{
+    bool hit;
+    float time; // how far through the move the contact is, from 0 to 1, or 1 if nothing was hit
+    vector normal; // points out of the face that was hit, zero if nothing was hit
+} sweep_hit;
+
+sweep_hit sweep_segment(map* the_map, vector start, vector move);
+sweep_hit sweep_box(map* the_map, vector center, float size, vector move); // size is the width of the box
+bool sweep_slide(map* the_map, vector* center, float size, vector move); // moves a box, or a point if size is 0, as far as it can, sliding along any wall it hits. Returns true if it hit one
+float sweep_circle(vector start, vector move, vector center, float radius); // returns how far through the move the point first touches the circle, from 0 to 1, or -1 if it doesn't
@@ -0,0 +1,170 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "texture_cache.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Cache file constants
+const uint32_t TEXTURE_CACHE_MAGIC = 0x54434152; // "RACT"
+const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+const int TEXTURE_TRANSPOSE_BLOCK = 8; // tiles are transposed in blocks this big so both sides stay in cache
+
+// Kept at 32 bytes so the texels after it stay aligned for vector loads
+typedef struct texture_cache_header{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    uint32_t pixel_format;
+    int32_t texture_size;
+    int32_t sprite_count;
+    uint32_t padding;
+} texture_cache_header;
+
+uint64_t texture_cache_hash(const void* data, size_t size){
+
+    // 64 bit FNV-1a
+    const unsigned char* bytes = (const unsigned char*)data;
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < size; i++){
+
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+texture_cache* texture_cache_open(const char* path, uint64_t source_hash, uint32_t pixel_format, int texture_size){
+
+    int file = open(path, O_RDONLY);
+    if(file == -1){
+
+        return NULL;
+    }
+
+    struct stat file_info;
+    if(fstat(file, &file_info) == -1 || (size_t)file_info.st_size < sizeof(texture_cache_header)){
+
+        close(file);
+        return NULL;
+    }
+
+    size_t mapping_size = (size_t)file_info.st_size;
+    void* mapping = mmap(NULL, mapping_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if(mapping == MAP_FAILED){
+
+        return NULL;
+    }
+
+    const texture_cache_header* header = (const texture_cache_header*)mapping;
+    size_t texel_count = (size_t)header->sprite_count * header->texture_size * header->texture_size;
+    if(header->magic != TEXTURE_CACHE_MAGIC || header->version != TEXTURE_CACHE_VERSION || header->source_hash != source_hash || header->pixel_format != pixel_format || header->texture_size != texture_size || header->sprite_count < 0 || mapping_size != sizeof(texture_cache_header) + (texel_count * sizeof(uint32_t))){
+
+        munmap(mapping, mapping_size);
+        return NULL;
+    }
+
+    texture_cache* cache = malloc(sizeof(texture_cache));
+    cache->mapping = mapping;
+    cache->mapping_size = mapping_size;
+    cache->sprite_count = header->sprite_count;
+    cache->texture_size = header->texture_size;
+    cache->texels = (uint32_t*)((char*)mapping + sizeof(texture_cache_header));
+
+    return cache;
+}
+
+void texture_cache_close(texture_cache* cache){
+
+    munmap(cache->mapping, cache->mapping_size);
+    free(cache);
+}
+
+bool texture_cache_write(const char* path, uint64_t source_hash, uint32_t pixel_format, int texture_size, int sprite_count, uint32_t** sprites){
+
+    // Make the directory the cache goes in if it isn't there yet
+    char directory[256];
+    const char* last_slash = strrchr(path, '/');
+    if(last_slash != NULL && (size_t)(last_slash - path) < sizeof(directory)){
+
+        memcpy(directory, path, last_slash - path);
+        directory[last_slash - path] = '\0';
+        mkdir(directory, 0755);
+    }
+
+    // Written to a temporary file first so that a half written cache is never mistaken for a whole one
+    char temporary_path[256];
+    if(snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path) >= (int)sizeof(temporary_path)){
+
+        printf("Error! Texture cache path %s is too long\n", path);
+        return false;
+    }
+
+    FILE* file = fopen(temporary_path, "wb");
+    if(file == NULL){
+
+        printf("Error! Unable to write texture cache %s\n", temporary_path);
+        return false;
+    }
+
+    texture_cache_header header = (texture_cache_header){
+        .magic = TEXTURE_CACHE_MAGIC,
+        .version = TEXTURE_CACHE_VERSION,
+        .source_hash = source_hash,
+        .pixel_format = pixel_format,
+        .texture_size = texture_size,
+        .sprite_count = sprite_count,
+        .padding = 0
+    };
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    size_t sprite_texels = (size_t)texture_size * texture_size;
+    for(int i = 0; i < sprite_count && success; i++){
+
+        success = fwrite(sprites[i], sizeof(uint32_t), sprite_texels, file) == sprite_texels;
+    }
+    success = fclose(file) == 0 && success;
+
+    if(!success || rename(temporary_path, path) != 0){
+
+        printf("Error! Unable to write texture cache %s\n", path);
+        remove(temporary_path);
+        return false;
+    }
+
+    return true;
+}
+
+void texture_clear_transparent(uint32_t* restrict pixels, int count){
+
+    for(int i = 0; i < count; i++){
+
+        pixels[i] = (pixels[i] >> 24) == 0 ? 0 : pixels[i];
+    }
+}
+
+void texture_transpose_tile(const uint32_t* restrict source, int source_pitch, uint32_t* restrict dest, int size){
+
+    for(int block_x = 0; block_x < size; block_x += TEXTURE_TRANSPOSE_BLOCK){
+
+        int end_x = block_x + TEXTURE_TRANSPOSE_BLOCK < size ? block_x + TEXTURE_TRANSPOSE_BLOCK : size;
+        for(int block_y = 0; block_y < size; block_y += TEXTURE_TRANSPOSE_BLOCK){
+
+            int end_y = block_y + TEXTURE_TRANSPOSE_BLOCK < size ? block_y + TEXTURE_TRANSPOSE_BLOCK : size;
+            for(int x = block_x; x < end_x; x++){
+
+                for(int y = block_y; y < end_y; y++){
+
+                    dest[y + (x * size)] = source[x + (y * source_pitch)];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Keeps spritesheets that have already been converted for the renderer on disk, so they don't have to be converted again
+ *
+ * A cache file is a short header followed by every sprite's texels exactly as the renderer reads them, in the screen
+ * buffer's pixel format and column major order. The header records a hash of the source image file along with the
+ * pixel format and texture size it was converted for, and if any of them don't match the cache is stale and ignored.
+ * A good cache file is mapped into memory whole, so loading it costs about as much as the pages that get touched
+ *
+ * When there's no good cache the image has to be converted, texture_clear_transparent() and texture_transpose_tile()
+ * do the per texel work in plain loops over whole rows that the compiler can vectorize
+ */
+
+typedef struct texture_cache{
+    void* mapping;
+    size_t mapping_size;
+
+    int sprite_count;
+    int texture_size;
+    uint32_t* texels; // every sprite one after the other, each texture_size * texture_size texels
+} texture_cache;
+
+uint64_t texture_cache_hash(const void* data, size_t size);
+
+texture_cache* texture_cache_open(const char* path, uint64_t source_hash, uint32_t pixel_format, int texture_size); // returns NULL if the file is missing or stale
+void texture_cache_close(texture_cache* cache);
+bool texture_cache_write(const char* path, uint64_t source_hash, uint32_t pixel_format, int texture_size, int sprite_count, uint32_t** sprites);
+
+void texture_clear_transparent(uint32_t* restrict pixels, int count); // zeroes every 32 bit pixel whose top byte, the alpha, is zero
+void texture_transpose_tile(const uint32_t* restrict source, int source_pitch, uint32_t* restrict dest, int size); // copies a size by size tile out of a row major image into column major order. source_pitch is in pixels
@@ -0,0 +1,155 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "texture_residency.h"
+#include "vector_array.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double residency_seconds(){
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + (time.tv_nsec / 1000000000.0);
+}
+
+texture_residency* texture_residency_create(size_t budget, residency_loader load, residency_unloader unload){
+
+    texture_residency* residency = malloc(sizeof(texture_residency));
+
+    residency->entry_capacity = 16;
+    residency->entry_count = 0;
+    residency->entries = malloc(sizeof(residency_entry) * residency->entry_capacity);
+
+    residency->load = load;
+    residency->unload = unload;
+
+    residency->budget = budget;
+    residency->frame = 0;
+
+    residency->stalls = 0;
+    residency->stall_seconds = 0;
+    residency->evictions = 0;
+
+    return residency;
+}
+
+void texture_residency_free(texture_residency* residency){
+
+    for(int i = 0; i < residency->entry_count; i++){
+
+        if(residency->entries[i].texture != NULL){
+
+            residency->unload(residency->entries[i].texture);
+        }
+    }
+    free(residency->entries);
+    free(residency);
+}
+
+int texture_residency_add(texture_residency* residency, const char* path){
+
+    residency_entry entry = (residency_entry){
+        .texture = NULL,
+        .bytes = 0,
+        .last_used = -1,
+        .failed = false
+    };
+    if(snprintf(entry.path, sizeof(entry.path), "%s", path) >= (int)sizeof(entry.path)){
+
+        printf("Error! Texture path %s is too long\n", path);
+        return -1;
+    }
+
+    vector_array_push((void**)&residency->entries, &entry, &residency->entry_count, &residency->entry_capacity, sizeof(residency_entry));
+    return residency->entry_count - 1;
+}
+
+bool texture_residency_load(texture_residency* residency, int id){
+
+    residency_entry* entry = &residency->entries[id];
+    if(entry->texture == NULL && !entry->failed){
+
+        entry->texture = residency->load(id, entry->path, &entry->bytes);
+        entry->failed = entry->texture == NULL;
+    }
+
+    return entry->texture != NULL;
+}
+
+void* texture_residency_use(texture_residency* residency, int id){
+
+    residency_entry* entry = &residency->entries[id];
+    if(entry->texture == NULL && !entry->failed){
+
+        double before = residency_seconds();
+        texture_residency_load(residency, id);
+        residency->stall_seconds += residency_seconds() - before;
+        residency->stalls++;
+    }
+    entry->last_used = residency->frame;
+
+    return entry->texture;
+}
+
+void texture_residency_end_frame(texture_residency* residency){
+
+    size_t resident_bytes = texture_residency_resident_bytes(residency);
+    while(resident_bytes > residency->budget){
+
+        int oldest = -1;
+        for(int i = 0; i < residency->entry_count; i++){
+
+            residency_entry* entry = &residency->entries[i];
+            if(entry->texture != NULL && entry->last_used != residency->frame && (oldest == -1 || entry->last_used < residency->entries[oldest].last_used)){
+
+                oldest = i;
+            }
+        }
+
+        // Everything left was used this frame
+        if(oldest == -1){
+
+            break;
+        }
+
+        residency_entry* entry = &residency->entries[oldest];
+        residency->unload(entry->texture);
+        entry->texture = NULL;
+        resident_bytes -= entry->bytes;
+        entry->bytes = 0;
+        residency->evictions++;
+    }
+
+    residency->frame++;
+}
+
+void texture_residency_unload_all(texture_residency* residency){
+
+    for(int i = 0; i < residency->entry_count; i++){
+
+        residency_entry* entry = &residency->entries[i];
+        if(entry->texture != NULL){
+
+            residency->unload(entry->texture);
+            entry->texture = NULL;
+            entry->bytes = 0;
+        }
+        entry->failed = false;
+    }
+}
+
+size_t texture_residency_resident_bytes(texture_residency* residency){
+
+    size_t bytes = 0;
+    for(int i = 0; i < residency->entry_count; i++){
+
+        if(residency->entries[i].texture != NULL){
+
+            bytes += residency->entries[i].bytes;
+        }
+    }
+
+    return bytes;
+}
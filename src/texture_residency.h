@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Decides which textures are kept loaded, so that memory only goes to the ones that are actually being drawn
+ *
+ * Every texture the game might use is registered up front by path, but nothing is loaded until it's asked for. A
+ * texture asked for with texture_residency_use() that isn't loaded yet is loaded on the spot, which holds up the
+ * frame, so those loads are counted as stalls. Textures that are known to be needed soon should be loaded ahead of
+ * time with texture_residency_load(), which only touches the one entry so different entries can be loaded in parallel
+ *
+ * Each use is stamped with the current frame. At the end of every frame, while more bytes are loaded than the budget
+ * allows, the texture that went the longest without being used is freed. Textures used this frame are never freed, so
+ * a frame that needs more than the budget goes over it rather than thrashing
+ *
+ * What a texture actually is is up to the owner, who passes in the functions that load and free one
+ */
+
+typedef void* (*residency_loader)(int id, const char* path, size_t* bytes); // returns NULL if the texture couldn't be loaded
+typedef void (*residency_unloader)(void* texture);
+
+typedef struct residency_entry{
+    char path[128];
+    void* texture; // NULL while it isn't loaded
+    size_t bytes;
+    int last_used; // frame it was last used on, -1 if never
+    bool failed; // it couldn't be loaded, so it isn't tried again
+} residency_entry;
+
+typedef struct texture_residency{
+    residency_entry* entries;
+    int entry_count;
+    int entry_capacity;
+
+    residency_loader load;
+    residency_unloader unload;
+
+    size_t budget;
+    int frame;
+
+    // Stats
+    int stalls; // textures loaded by texture_residency_use() since the residency was made
+    double stall_seconds;
+    int evictions;
+} texture_residency;
+
+texture_residency* texture_residency_create(size_t budget, residency_loader load, residency_unloader unload);
+void texture_residency_free(texture_residency* residency); // frees every loaded texture too
+
+int texture_residency_add(texture_residency* residency, const char* path); // registers a texture without loading it and returns its id
+bool texture_residency_load(texture_residency* residency, int id); // loads the texture if it isn't already, returns false if it couldn't be
+void* texture_residency_use(texture_residency* residency, int id); // returns the texture, loading it first if it has to. NULL if it couldn't be loaded
+void texture_residency_end_frame(texture_residency* residency); // frees the least recently used textures until it's back under budget
+void texture_residency_unload_all(texture_residency* residency); // frees every loaded texture, for when they all have to be loaded differently
+
+size_t texture_residency_resident_bytes(texture_residency* residency);
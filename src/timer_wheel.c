@@ -0,0 +1,194 @@
+#include "timer_wheel.h"
+#include "vector_array.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+// Wheel constants
+const int TIMER_WHEEL_BITS = 6;
+const int TIMER_WHEEL_SLOTS = 64;
+const int TIMER_WHEEL_LEVELS = 4;
+
+static void bucket_link(timer_wheel* wheel, int timer, int bucket){
+
+    timer_entry* current = &wheel->entries[timer];
+    current->bucket = bucket;
+    current->previous = -1;
+    current->next = wheel->buckets[bucket];
+    if(current->next != -1){
+
+        wheel->entries[current->next].previous = timer;
+    }
+    wheel->buckets[bucket] = timer;
+}
+
+static void bucket_unlink(timer_wheel* wheel, int timer){
+
+    timer_entry* current = &wheel->entries[timer];
+    if(current->previous != -1){
+
+        wheel->entries[current->previous].next = current->next;
+
+    }else{
+
+        wheel->buckets[current->bucket] = current->next;
+    }
+    if(current->next != -1){
+
+        wheel->entries[current->next].previous = current->previous;
+    }
+}
+
+static void entry_release(timer_wheel* wheel, int timer){
+
+    wheel->entries[timer].owner = -1;
+    wheel->entries[timer].next = wheel->free_entry;
+    wheel->free_entry = timer;
+}
+
+// Puts the timer in the lowest level whose buckets it fits in, measured from the next time to be run
+static void place(timer_wheel* wheel, int timer){
+
+    int next = wheel->now + 1;
+    int distance = wheel->entries[timer].due - next;
+    int due = wheel->entries[timer].due;
+
+    // Further away than the wheel reaches, it's parked in the furthest bucket and placed again when that comes round.
+    // The top level's last bucket is left out of its reach, otherwise it would be the one being run right now
+    int reach = (1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - (1 << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVELS - 1)));
+    if(distance >= reach){
+
+        distance = reach - 1;
+        due = next + distance;
+    }
+
+    int level = 0;
+    while(level < TIMER_WHEEL_LEVELS - 1 && distance >= 1 << (TIMER_WHEEL_BITS * (level + 1))){
+
+        level++;
+    }
+    int slot = (due >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    bucket_link(wheel, timer, (level * TIMER_WHEEL_SLOTS) + slot);
+}
+
+// Spreads a bucket out over the levels below it
+static void cascade(timer_wheel* wheel, int bucket){
+
+    int timer = wheel->buckets[bucket];
+    wheel->buckets[bucket] = -1;
+    while(timer != -1){
+
+        int next = wheel->entries[timer].next;
+        place(wheel, timer);
+        timer = next;
+    }
+}
+
+timer_wheel* timer_wheel_create(){
+
+    timer_wheel* wheel = malloc(sizeof(timer_wheel));
+    wheel->now = 0;
+
+    wheel->buckets = malloc(sizeof(int) * TIMER_WHEEL_SLOTS * TIMER_WHEEL_LEVELS);
+    for(int i = 0; i < TIMER_WHEEL_SLOTS * TIMER_WHEEL_LEVELS; i++){
+
+        wheel->buckets[i] = -1;
+    }
+
+    wheel->entry_capacity = 16;
+    wheel->entry_count = 0;
+    wheel->entries = malloc(sizeof(timer_entry) * wheel->entry_capacity);
+    wheel->free_entry = -1;
+
+    wheel->fired_capacity = 16;
+    wheel->fired_count = 0;
+    wheel->fired = malloc(sizeof(timer_event) * wheel->fired_capacity);
+
+    return wheel;
+}
+
+void timer_wheel_free(timer_wheel* wheel){
+
+    free(wheel->buckets);
+    free(wheel->entries);
+    free(wheel->fired);
+    free(wheel);
+}
+
+int timer_wheel_schedule(timer_wheel* wheel, float delay, int kind, int owner){
+
+    int timer = wheel->free_entry;
+    if(timer != -1){
+
+        wheel->free_entry = wheel->entries[timer].next;
+
+    }else{
+
+        timer_entry blank;
+        vector_array_push((void**)&wheel->entries, &blank, &wheel->entry_count, &wheel->entry_capacity, sizeof(timer_entry));
+        timer = wheel->entry_count - 1;
+    }
+
+    int due = wheel->now + (int)ceil(delay);
+    wheel->entries[timer].kind = kind;
+    wheel->entries[timer].owner = owner;
+    wheel->entries[timer].due = due > wheel->now ? due : wheel->now + 1;
+    place(wheel, timer);
+
+    return timer;
+}
+
+void timer_wheel_cancel(timer_wheel* wheel, int timer){
+
+    if(wheel->entries[timer].bucket == -1){
+
+        return;
+    }
+    bucket_unlink(wheel, timer);
+    entry_release(wheel, timer);
+}
+
+void timer_wheel_set_owner(timer_wheel* wheel, int timer, int owner){
+
+    wheel->entries[timer].owner = owner;
+}
+
+int timer_wheel_advance(timer_wheel* wheel, int time){
+
+    // The last advance's timers have been handled by now
+    for(int i = 0; i < wheel->fired_count; i++){
+
+        entry_release(wheel, wheel->fired[i].timer);
+    }
+    wheel->fired_count = 0;
+
+    for(int i = 0; i < time; i++){
+
+        // Whenever a level wraps round, the next bucket of the level above is due to be spread out
+        int next = wheel->now + 1;
+        for(int level = 1; level < TIMER_WHEEL_LEVELS; level++){
+
+            if(((next >> (TIMER_WHEEL_BITS * (level - 1))) & (TIMER_WHEEL_SLOTS - 1)) != 0){
+
+                break;
+            }
+            cascade(wheel, (level * TIMER_WHEEL_SLOTS) + ((next >> (TIMER_WHEEL_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)));
+        }
+
+        // Everything left in the first level's bucket is due now
+        int bucket = next & (TIMER_WHEEL_SLOTS - 1);
+        int timer = wheel->buckets[bucket];
+        wheel->buckets[bucket] = -1;
+        while(timer != -1){
+
+            int following = wheel->entries[timer].next;
+            timer_event event = (timer_event){ .timer = timer, .kind = wheel->entries[timer].kind, .owner = wheel->entries[timer].owner };
+            vector_array_push((void**)&wheel->fired, &event, &wheel->fired_count, &wheel->fired_capacity, sizeof(timer_event));
+            wheel->entries[timer].bucket = -1;
+            timer = following;
+        }
+        wheel->now = next;
+    }
+
+    return wheel->fired_count;
+}
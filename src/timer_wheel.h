@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+ * Schedules events to fire at a later time without having to look at them every tick until they do
+ *
+ * Time is counted in whole units of the update delta, so 1 is one update at the target update rate. Events are
+ * kept in a hierarchical timing wheel: the first level has a bucket for each of the next 64 units, the second a bucket
+ * for each of the next 64 blocks of 64 units and so on. Every 64 units the next bucket of the level above is spread
+ * out over the level below, so scheduling, cancelling and advancing are all constant time however many events are
+ * waiting and however far away they are
+ *
+ * An event is an owner and a kind, what they mean is up to whoever scheduled it. timer_wheel_advance() collects the
+ * events that came due into fired, in the order they came due. A fired timer is only reused after the next advance,
+ * so while they're being handled cancelling one that already fired does nothing, and an owner can tell if an event
+ * is stale by checking whether it still holds that timer. Like the spatial hash, when an owner's index changes the
+ * timer has to be told with timer_wheel_set_owner()
+ */
+
+typedef struct timer_entry{
+    int kind;
+    int owner; // -1 while the entry is free
+    int due;
+    int bucket; // -1 once it's fired
+    int previous;
+    int next; // next entry in the bucket, or the next free entry
+} timer_entry;
+
+typedef struct timer_event{
+    int timer;
+    int kind;
+    int owner;
+} timer_event;
+
+typedef struct timer_wheel{
+    int now;
+
+    int* buckets; // first entry in each bucket, or -1, level by level
+
+    timer_entry* entries;
+    int entry_count;
+    int entry_capacity;
+    int free_entry;
+
+    timer_event* fired; // events fired by the last advance
+    int fired_count;
+    int fired_capacity;
+} timer_wheel;
+
+timer_wheel* timer_wheel_create();
+void timer_wheel_free(timer_wheel* wheel);
+
+int timer_wheel_schedule(timer_wheel* wheel, float delay, int kind, int owner); // returns the timer, which fires delay from now rounded up and never sooner than the next advance
+void timer_wheel_cancel(timer_wheel* wheel, int timer); // does nothing if the timer has already fired
+void timer_wheel_set_owner(timer_wheel* wheel, int timer, int owner);
+int timer_wheel_advance(timer_wheel* wheel, int time); // moves the wheel time units forward and returns how many events fired
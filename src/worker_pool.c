@@ -0,0 +1,129 @@
+#include "worker_pool.h"
+
+#include <stdlib.h>
+
+// Works on chunks of the current loop until there are none left to hand out, the lock must be held when calling this
+static void pool_work(worker_pool* pool){
+
+    while(pool->next_chunk < pool->chunk_count){
+
+        int chunk = pool->next_chunk;
+        pool->next_chunk++;
+
+        int begin = chunk * pool->chunk_size;
+        int end = begin + pool->chunk_size < pool->count ? begin + pool->chunk_size : pool->count;
+        pthread_mutex_unlock(&pool->lock);
+        pool->job(pool->data, begin, end);
+        pthread_mutex_lock(&pool->lock);
+
+        pool->chunks_left--;
+        if(pool->chunks_left == 0){
+
+            pthread_cond_signal(&pool->done);
+        }
+    }
+}
+
+static void* pool_thread_main(void* data){
+
+    worker_pool* pool = (worker_pool*)data;
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->running){
+
+        if(pool->next_chunk < pool->chunk_count){
+
+            pool_work(pool);
+            continue;
+        }
+        pthread_cond_wait(&pool->start, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+worker_pool* worker_pool_create(int thread_count){
+
+    worker_pool* pool = malloc(sizeof(worker_pool));
+
+    pool->thread_count = thread_count;
+    pool->running = true;
+    pool->chunk_count = 0;
+    pool->next_chunk = 0;
+    pool->chunks_left = 0;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    pool->threads = malloc(sizeof(pthread_t) * (thread_count > 0 ? thread_count : 1));
+    for(int i = 0; i < thread_count; i++){
+
+        pthread_create(&pool->threads[i], NULL, pool_thread_main, pool);
+    }
+
+    return pool;
+}
+
+void worker_pool_free(worker_pool* pool){
+
+    pthread_mutex_lock(&pool->lock);
+    pool->running = false;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for(int i = 0; i < pool->thread_count; i++){
+
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool);
+}
+
+void worker_pool_start(worker_pool* pool, worker_job job, void* data, int count, int chunk_size){
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->data = data;
+    pool->count = count > 0 ? count : 0;
+    pool->chunk_size = chunk_size;
+    pool->chunk_count = (pool->count + chunk_size - 1) / chunk_size;
+    pool->chunks_left = pool->chunk_count;
+    pool->next_chunk = 0;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void worker_pool_wait(worker_pool* pool){
+
+    pthread_mutex_lock(&pool->lock);
+    pool_work(pool);
+    while(pool->chunks_left != 0){
+
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void worker_pool_run(worker_pool* pool, worker_job job, void* data, int count, int chunk_size){
+
+    if(count <= 0){
+
+        return;
+    }
+
+    // Not worth waking anybody up for
+    if(pool->thread_count == 0 || count <= chunk_size){
+
+        job(data, 0, count);
+        return;
+    }
+
+    worker_pool_start(pool, job, data, count, chunk_size);
+    worker_pool_wait(pool);
+}
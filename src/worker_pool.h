@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/*
+ * A fixed set of threads for splitting a loop over many entities into chunks
+ *
+ * worker_pool_run() hands the chunks out to the pool's threads and works on them itself too, and doesn't return
+ * until every chunk is done. Which thread runs which chunk isn't fixed, so the job has to give the same result no
+ * matter how the chunks are split up, which in practice means each call may only write to the entities in its own
+ * range. A pool with no threads just runs the whole loop on the calling thread
+ *
+ * A loop can also be started with worker_pool_start(), which returns straight away and leaves the pool's threads
+ * working on it in the background. worker_pool_wait() then works on whatever chunks are left and returns once they're
+ * all done. Only one loop can be running at a time, so every start has to be waited on before the next one
+ */
+
+typedef void (*worker_job)(void* data, int begin, int end); // does the work for entities begin to end - 1
+
+typedef struct worker_pool{
+    pthread_t* threads;
+    int thread_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start; // signalled when there are chunks to work on
+    pthread_cond_t done; // signalled when the last chunk is finished
+    bool running;
+
+    // The loop currently being run
+    worker_job job;
+    void* data;
+    int count;
+    int chunk_size;
+    int chunk_count;
+    int next_chunk; // first chunk that hasn't been handed out yet
+    int chunks_left; // chunks that haven't finished yet
+} worker_pool;
+
+worker_pool* worker_pool_create(int thread_count);
+void worker_pool_free(worker_pool* pool);
+void worker_pool_run(worker_pool* pool, worker_job job, void* data, int count, int chunk_size);
+void worker_pool_start(worker_pool* pool, worker_job job, void* data, int count, int chunk_size);
+void worker_pool_wait(worker_pool* pool);